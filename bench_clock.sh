@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Clock tick rate against the number of workers reading the clock, with
+# one clock line for everyone and with replicated lines (oss -C). Workers
+# poll flat out (-W 0:0:0) so the clock line is as contended as it gets;
+# what matters is how fast oss can still tick. Prints the ticks per real
+# second over the whole run and the p50/p99 gap between ticks. Build p2
+# first. On a single node with one LLC, pass a count ("-C 4") to see the
+# cost of the copies themselves.
+#
+# Usage: ./bench_clock.sh [replication] [timelimit] [workers ...]
+# replication is the -C argument (default llc); workers default to 1 2 4 8.
+
+REPLICATION="${1:-llc}"
+TIMELIMIT="${2:-1}"
+shift 2 2>/dev/null || shift $#
+COUNTS=("$@")
+if [ ${#COUNTS[@]} -eq 0 ]; then
+	COUNTS=(1 2 4 8)
+fi
+
+if [ ! -x ./oss ] || [ ! -x ./worker ]; then
+	echo "Error: ./oss and ./worker not found; run make first."
+	exit 1
+fi
+
+# Field 'name' (n, p50, p99, ...) of the oss summary line starting with 'prefix'
+field() {
+	echo "$1" | grep "^$2" | sed -n "s/.* $3=\([0-9]*\).*/\1/p"
+}
+
+echo "workload: -t $TIMELIMIT -i 10 -W 0:0:0, replicated with -C $REPLICATION, $(nproc) online CPU(s)"
+printf "%-8s %-12s %14s %12s %12s %9s\n" "workers" "clock" "ticks/s" "gap p50 ns" "gap p99 ns" "wall ms"
+for workers in "${COUNTS[@]}"; do
+	for mode in single replicated; do
+		args=()
+		[ "$mode" = "replicated" ] && args=(-C "$REPLICATION")
+		start=$(date +%s%N)
+		out=$(./oss -n "$workers" -s "$workers" -t "$TIMELIMIT" -i 10 -W 0:0:0 "${args[@]}")
+		end=$(date +%s%N)
+		ticks=$(field "$out" "OSS: latency tick gap" n)
+		wall_ms=$(((end - start) / 1000000))
+		printf "%-8d %-12s %14d %12s %12s %9d\n" "$workers" "$mode" $((${ticks:-0} * 1000 / (wall_ms > 0 ? wall_ms : 1))) \
+			"$(field "$out" "OSS: latency tick gap" p50)" "$(field "$out" "OSS: latency tick gap" p99)" "$wall_ms"
+	done
+done
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# Dispatch throughput of oss -K as the number of dispatcher threads grows.
+# Runs the same scheduled workload per K (1, 2, 4, ... up to the online
+# CPU count, or max_k, and never past oss's limit of 20), once with forks
+# and reaping on oss's main thread and once with -M, and prints the
+# scheduler's dispatches per real second, the steals and the wall time of
+# each run. Build p2 first.
+#
+# Usage: ./bench_dispatch.sh [workers] [simul] [timelimit] [max_k]
+
+WORKERS="${1:-60}"
+SIMUL="${2:-18}"
+TIMELIMIT="${3:-1}"
+CPUS=$(nproc)
+MAX_K="${4:-$CPUS}"
+# oss rejects -K above MAX_PROCESSES (p2/segment.h)
+MAX_PROCESSES=20
+if [ "$MAX_K" -gt "$CPUS" ]; then MAX_K="$CPUS"; fi
+if [ "$MAX_K" -gt "$MAX_PROCESSES" ]; then MAX_K="$MAX_PROCESSES"; fi
+
+if [ ! -x ./oss ] || [ ! -x ./worker ]; then
+	echo "Error: ./oss and ./worker not found; run make first."
+	exit 1
+fi
+
+# run_once <k> [-M]
+run_once() {
+	local k="$1"
+	local mode="$2"
+	local start end out
+	start=$(date +%s%N)
+	out=$(./oss -n "$WORKERS" -s "$SIMUL" -t "$TIMELIMIT" -i 0 -K "$k" $mode)
+	end=$(date +%s%N)
+
+	local rate steals
+	rate=$(echo "$out" | sed -n 's/^OSS: scheduler: dispatches=[0-9]* (\([0-9]*\)\/s).*/\1/p')
+	steals=$(echo "$out" | sed -n 's/^OSS: dispatcher .* steals=\([0-9]*\).*/\1/p' | awk '{ s += $1 } END { print s + 0 }')
+	printf "%4d %5s %14s %10s %10d\n" "$k" "${mode:--}" "${rate:-?}" "$steals" $(((end - start) / 1000000))
+}
+
+run_both() {
+	run_once "$1"
+	run_once "$1" -M
+}
+
+echo "workload: -n $WORKERS -s $SIMUL -t $TIMELIMIT, $CPUS online CPU(s)"
+printf "%4s %5s %14s %10s %10s\n" "K" "mode" "dispatches/s" "steals" "wall ms"
+k=1
+while [ "$k" -le "$MAX_K" ]; do
+	run_both "$k"
+	k=$((k * 2))
+done
+# Always show the top end, even when it is not a power of two
+if [ $((k / 2)) -ne "$MAX_K" ]; then
+	run_both "$MAX_K"
+fi
@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Worker clock-polling strategies (oss -W) side by side. Runs the same
+# free-running workload once per setting and prints what the workers cost
+# (user and system CPU, voluntary context switches, i.e. parks) and how
+# late they noticed their end time (overshoot, sim ns). Build p2 first.
+#
+# Usage: ./bench_poll.sh [workers] [simul] [timelimit] [interval_ms] [setting ...]
+# A setting is spin:backoff:park_us as for oss -W; "default" runs without -W.
+
+WORKERS="${1:-8}"
+SIMUL="${2:-4}"
+TIMELIMIT="${3:-2}"
+INTERVAL="${4:-100}"
+shift 4 2>/dev/null || shift $#
+SETTINGS=("$@")
+if [ ${#SETTINGS[@]} -eq 0 ]; then
+	SETTINGS=("0:0:0" "100:0:0" "100:1024:0" "default" "100:1024:20000" "100:1024:200")
+fi
+
+if [ ! -x ./oss ] || [ ! -x ./worker ]; then
+	echo "Error: ./oss and ./worker not found; run make first."
+	exit 1
+fi
+
+# Field 'name' (total, p50, p99, max, ...) of the oss summary line starting with 'prefix'
+field() {
+	echo "$1" | grep "^$2" | sed -n "s/.* $3=\([0-9]*\).*/\1/p"
+}
+
+echo "workload: -n $WORKERS -s $SIMUL -t $TIMELIMIT -i $INTERVAL, $(nproc) online CPU(s)"
+printf "%-16s %12s %12s %10s %14s %14s %14s %9s\n" "setting" "user cpu ms" "sys cpu ms" "vol csw" \
+	"overshoot p50" "overshoot p99" "overshoot max" "wall ms"
+for setting in "${SETTINGS[@]}"; do
+	args=()
+	[ "$setting" != "default" ] && args=(-W "$setting")
+	start=$(date +%s%N)
+	out=$(./oss -n "$WORKERS" -s "$SIMUL" -t "$TIMELIMIT" -i "$INTERVAL" "${args[@]}")
+	end=$(date +%s%N)
+	user=$(field "$out" "OSS: worker usage user cpu" total)
+	sys=$(field "$out" "OSS: worker usage sys cpu" total)
+	csw=$(field "$out" "OSS: worker usage voluntary csw" total)
+	printf "%-16s %12d %12d %10s %14s %14s %14s %9d\n" "$setting" $((${user:-0} / 1000)) $((${sys:-0} / 1000)) \
+		"${csw:-?}" "$(field "$out" "OSS: latency overshoot" p50)" "$(field "$out" "OSS: latency overshoot" p99)" \
+		"$(field "$out" "OSS: latency overshoot" max)" $(((end - start) / 1000000))
+done
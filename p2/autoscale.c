@@ -0,0 +1,96 @@
+// autoscale.c
+
+#include "autoscale.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// "some avg10=0.00 avg60=0.00 avg300=0.00 total=12345" -> 12345, -1 on error
+static long long read_psi_total(int fd) {
+    char buf[256];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    if (strncmp(buf, "some ", 5) != 0) return -1;
+    char *nl    = strchr(buf, '\n');
+    char *total = strstr(buf, "total=");
+    if (!total || (nl && total > nl)) return -1;
+    return strtoll(total + 6, NULL, 10);
+}
+
+static int clamp_ceiling(const struct Autoscale *as, int c) {
+    if (c < 1) return 1;
+    return c > as->limit ? as->limit : c;
+}
+
+void autoscale_init(struct Autoscale *as, int limit) {
+    memset(as, 0, sizeof(*as));
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    as->cpus     = cpus > 0 ? (int)cpus : 1;
+    as->limit    = limit;
+    as->ceiling  = clamp_ceiling(as, as->cpus - 1);
+    as->min_seen = as->max_seen = as->ceiling;
+    as->ratio    = -1.0;
+    as->pressure = -1.0;
+    as->psi_fd   = open("/proc/pressure/cpu", O_RDONLY | O_CLOEXEC);
+    if (as->psi_fd >= 0) {
+        as->last_psi_us = read_psi_total(as->psi_fd);
+        if (as->last_psi_us < 0) {
+            close(as->psi_fd);
+            as->psi_fd = -1;
+        }
+    }
+}
+
+int autoscale_step(struct Autoscale *as, long long real_ns, long long sim_ns, int track_clock, int active,
+                   int pending) {
+    if (as->last_real_ns == 0) {
+        as->last_real_ns = real_ns;
+        as->last_sim_ns  = sim_ns;
+        return as->ceiling;
+    }
+    long long real_passed = real_ns - as->last_real_ns;
+    if (real_passed < AUTOSCALE_PERIOD_NS) return as->ceiling;
+
+    as->ratio = track_clock ? (double)(sim_ns - as->last_sim_ns) / (double)real_passed : -1.0;
+    as->pressure = -1.0;
+    if (as->psi_fd >= 0) {
+        long long psi_us = read_psi_total(as->psi_fd);
+        if (psi_us >= as->last_psi_us) {
+            as->pressure    = (double)(psi_us - as->last_psi_us) * 1000.0 / (double)real_passed;
+            as->last_psi_us = psi_us;
+        }
+    }
+    as->last_real_ns = real_ns;
+    as->last_sim_ns  = sim_ns;
+
+    // A change needs a period to show up in the numbers: workers above a
+    // lowered ceiling still have to finish, new ones still have to start
+    if (as->settling) {
+        as->settling = 0;
+        return as->ceiling;
+    }
+
+    int next = as->ceiling;
+    if (as->ratio >= 0.0 && as->ratio < AUTOSCALE_BEHIND) {
+        int cut = as->ceiling / 4;
+        next = as->ceiling - (cut > 0 ? cut : 1);
+    } else if (pending && active >= as->ceiling && as->pressure < AUTOSCALE_PSI_HIGH) {
+        next = as->ceiling + 1;  // unknown pressure (-1) counts as room
+    }
+    next = clamp_ceiling(as, next);
+    if (next != as->ceiling) {
+        as->ceiling  = next;
+        as->settling = 1;
+        as->changes++;
+        if (next < as->min_seen) as->min_seen = next;
+        if (next > as->max_seen) as->max_seen = next;
+    }
+    return as->ceiling;
+}
+
+void autoscale_close(struct Autoscale *as) {
+    if (as->psi_fd >= 0) close(as->psi_fd);
+    as->psi_fd = -1;
+}
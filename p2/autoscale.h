@@ -0,0 +1,49 @@
+// autoscale.h
+
+#ifndef AUTOSCALE_H
+#define AUTOSCALE_H
+
+/*
+ * oss -s auto: the concurrency ceiling is a feedback loop instead of a
+ * constant. Every AUTOSCALE_PERIOD_NS of real time the controller looks at
+ *   - how far the simulated clock moved against real time (below
+ *     AUTOSCALE_BEHIND the workers are starving the ticking loop),
+ *   - the "some" line of /proc/pressure/cpu (share of the period in which
+ *     something runnable waited for a CPU),
+ *   - whether the ceiling is what holds workers back at all,
+ * and shrinks the ceiling by a quarter when the clock falls behind, grows it
+ * by one while it binds and the CPUs have room, and holds it otherwise.
+ * It starts at one worker per online CPU, leaving one for oss itself.
+ */
+
+#define AUTOSCALE_PERIOD_NS 250000000LL  // real time between decisions
+#define AUTOSCALE_BEHIND 0.95            // sim/real below this = falling behind
+#define AUTOSCALE_PSI_HIGH 0.25          // pressure above this = no room to grow
+
+struct Autoscale {
+  int ceiling;                // current concurrency limit
+  int limit;                  // hard upper bound (the process table)
+  int min_seen, max_seen;     // range the ceiling moved through
+  int changes;                // times the ceiling moved
+  int cpus;                   // online CPUs at start
+  int psi_fd;                 // /proc/pressure/cpu, -1 if the kernel has no PSI
+  int settling;               // skip one period after a change
+  long long last_psi_us;      // "some total" at the last decision
+  long long last_real_ns;     // real time of the last decision (0 = none yet)
+  long long last_sim_ns;      // sim time of the last decision
+  double ratio;               // sim/real over the last period, -1 if not measured
+  double pressure;            // CPU pressure over the last period, -1 if unknown
+};
+
+// Pick the starting ceiling and open the pressure file
+void autoscale_init( struct Autoscale *as, int limit );
+
+// Called from the loop with the current times; 'track_clock' is 0 when the
+// clock does not follow real time (-m). 'active' workers are running and
+// 'pending' is 1 while some are still to be launched. Returns the ceiling.
+int autoscale_step( struct Autoscale *as, long long real_ns, long long sim_ns, int track_clock, int active,
+                    int pending );
+
+void autoscale_close( struct Autoscale *as );
+
+#endif /* AUTOSCALE_H */
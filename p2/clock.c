@@ -1,13 +1,19 @@
 // clock.c
 
 #include "clock.h"
+#include "shared.h"
+#include <limits.h>
 #include <stdio.h>
+#include <time.h>
 
 // Initialize the clock to zero
 void initialize_clock(struct SysClock *sys_clock) {
     if (sys_clock) {
         sys_clock->sec = 0;
         sys_clock->nano = 0;
+        sys_clock->seq = 0;
+        sys_clock->wake_seq = 0;
+        sys_clock->wake_ns = LLONG_MAX;
     }
 }
 
@@ -15,11 +21,104 @@ void initialize_clock(struct SysClock *sys_clock) {
 void increment_clock(struct SysClock *sys_clock, long long tick_interval) {
     if (!sys_clock) return;
 
-    sys_clock->nano += tick_interval;
+    // Readers using read_clock() retry while seq is odd or has changed
+    __atomic_store_n(&sys_clock->seq, sys_clock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
 
-    // Convert any overflow of nanoseconds into seconds
-    while (sys_clock->nano >= 1000000000) {
-        sys_clock->nano -= 1000000000;
-        sys_clock->sec += 1;
+    // Convert any overflow of nanoseconds into seconds (oss -V can move
+    // the clock by more than an int holds after oss was preempted)
+    long long nano = sys_clock->nano + tick_interval;
+    sys_clock->sec += (int)(nano / 1000000000LL);
+    sys_clock->nano = (int)(nano % 1000000000LL);
+
+    __atomic_store_n(&sys_clock->seq, sys_clock->seq + 1, __ATOMIC_RELEASE);
+
+    // Wake the parked workers once the earliest of them is due
+    long long now_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    if (now_ns >= __atomic_load_n(&sys_clock->wake_ns, __ATOMIC_SEQ_CST)) clock_wake_parked(sys_clock);
+}
+
+void clock_wake_parked(struct SysClock *sys_clock) {
+    // wake_ns stays at LLONG_MAX while nobody is parked
+    if (__atomic_load_n(&sys_clock->wake_ns, __ATOMIC_SEQ_CST) == LLONG_MAX) return;
+    __atomic_store_n(&sys_clock->wake_ns, LLONG_MAX, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&sys_clock->wake_seq, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&sys_clock->wake_seq, INT_MAX);
+}
+
+// Consistent snapshot of the clock (seqlock read side)
+void read_clock(const struct SysClock *sys_clock, int *sec, int *nano) {
+    unsigned int before, after;
+    do {
+        before = __atomic_load_n(&sys_clock->seq, __ATOMIC_ACQUIRE);
+        *sec   = __atomic_load_n(&sys_clock->sec, __ATOMIC_RELAXED);
+        *nano  = __atomic_load_n(&sys_clock->nano, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&sys_clock->seq, __ATOMIC_RELAXED);
+    } while ((before & 1u) || before != after);
+}
+
+void clock_publish(const struct SysClock *sys_clock, struct ClockReplica *replicas, int count) {
+    int sec  = sys_clock->sec;  // only oss writes the clock, and oss calls this
+    int nano = sys_clock->nano;
+    for (int r = 0; r < count; r++) {
+        struct SysClock *copy = &replicas[r].clock;
+        if (copy->sec == sec && copy->nano == nano) continue;
+        __atomic_store_n(&copy->seq, copy->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        copy->sec  = sec;
+        copy->nano = nano;
+        __atomic_store_n(&copy->seq, copy->seq + 1, __ATOMIC_RELEASE);
     }
 }
+
+void clock_page_set_rate(struct ClockPage *page, long long sim_ns, long long real_ns, double rate) {
+    __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    page->sim_base_ns  = sim_ns;
+    page->real_base_ns = real_ns;
+    page->rate         = rate;
+    __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELEASE);
+}
+
+long long clock_page_read(const struct ClockPage *page, long long real_ns) {
+    unsigned int before, after;
+    long long sim_base, real_base;
+    double rate;
+    do {
+        before    = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        sim_base  = __atomic_load_n(&page->sim_base_ns, __ATOMIC_RELAXED);
+        real_base = __atomic_load_n(&page->real_base_ns, __ATOMIC_RELAXED);
+        rate      = page->rate;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&page->seq, __ATOMIC_RELAXED);
+    } while ((before & 1u) || before != after);
+    // Never before the base, even if the caller read real time before the rebase
+    return real_ns > real_base ? sim_base + (long long)((double)(real_ns - real_base) * rate) : sim_base;
+}
+
+void clock_park(struct SysClock *sys_clock, long long wake_ns, long long timeout_ns, const unsigned int *watch,
+                unsigned int watch_seen) {
+    // Read the word before publishing our time: if oss fires in between,
+    // the word has moved and futex_wait returns at once
+    unsigned int seen = __atomic_load_n(&sys_clock->wake_seq, __ATOMIC_SEQ_CST);
+    long long earliest = __atomic_load_n(&sys_clock->wake_ns, __ATOMIC_SEQ_CST);
+    while (wake_ns < earliest &&
+           !__atomic_compare_exchange_n(&sys_clock->wake_ns, &earliest, wake_ns, 0, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST)) {
+    }
+    // Whoever moves *watch does so before clock_wake_parked(), which sees
+    // our wake_ns: either we see the new value here or the word moves
+    if (watch && __atomic_load_n(watch, __ATOMIC_SEQ_CST) != watch_seen) return;
+    int sec, nano;
+    read_clock(sys_clock, &sec, &nano);
+    if ((long long)sec * 1000000000LL + nano >= wake_ns) return;
+    futex_wait(&sys_clock->wake_seq, seen, timeout_ns);
+}
+
+// Real (monotonic) time in nanoseconds
+long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -6,15 +6,44 @@
 /*
  * Simulated clock structure plus function prototypes for incrementing
  * and initializing. This clock is stored in shared memory and updated
- * by the parent (oss). The children (worker) only read it.
+ * by the parent (oss). The children (worker) only read it, except that a
+ * worker with far to go can park: it lowers wake_ns to the sim time it
+ * wants to be woken at and sleeps on wake_seq. increment_clock() compares
+ * the new time with wake_ns (one load on the line it already writes) and
+ * wakes every parked worker once it is reached; each re-parks for its own
+ * time if that is still ahead.
  */
 
 // Simple clock struct with seconds + nanoseconds
 struct SysClock {
-  int sec;   // Seconds
-  int nano;  // Nanoseconds
+  int sec;                // Seconds
+  int nano;               // Nanoseconds
+  unsigned int seq;       // odd while oss is updating sec/nano (seqlock)
+  unsigned int wake_seq;  // futex word parked workers sleep on, bumped when wake_ns is reached
+  long long wake_ns;      // earliest sim time a parked worker wants, LLONG_MAX if none
 };
 
+// oss -V: instead of having every reader load the clock oss writes each
+// tick, oss publishes how sim time follows real time and readers work it
+// out from their own CLOCK_MONOTONIC, the way the vDSO does for
+// gettimeofday(). The triple is only rewritten when the rate changes.
+struct ClockPage {
+  unsigned int seq;        // odd while oss rewrites the triple (seqlock)
+  int active;              // set once before workers start; 0 = read the clock
+  long long sim_base_ns;   // sim time at real_base_ns
+  long long real_base_ns;  // CLOCK_MONOTONIC
+  double rate;             // sim ns per real ns
+};
+
+// A copy of the clock on a line of its own (oss -C): workers on one NUMA
+// node or LLC domain read their replica instead of the line oss writes
+struct ClockReplica {
+  _Alignas( 64 ) struct SysClock clock;  // sec/nano/seq only; parking stays on the real clock
+};
+
+// Set by oss -W ("spin:backoff_max:park_ns"): how free-running workers poll the clock
+#define POLL_ENV "OSS_POLL"
+
 // Initializes the clock to zero
 void initialize_clock( struct SysClock *sys_clock );
 
@@ -22,4 +51,30 @@ void initialize_clock( struct SysClock *sys_clock );
 // carrying over to 'sec' if needed
 void increment_clock( struct SysClock *sys_clock, long long tick_interval );
 
+// Read sec/nano as a consistent pair without locking (retries while oss writes)
+void read_clock( const struct SysClock *sys_clock, int *sec, int *nano );
+
+// Copy the clock into each of 'count' replicas (seqlock writes, like increment_clock)
+void clock_publish( const struct SysClock *sys_clock, struct ClockReplica *replicas, int count );
+
+// Rebase the page to (sim_ns, real_ns) and run at 'rate' from there on
+void clock_page_set_rate( struct ClockPage *page, long long sim_ns, long long real_ns, double rate );
+
+// Sim time at real time real_ns according to the page
+long long clock_page_read( const struct ClockPage *page, long long real_ns );
+
+// Sleep until the clock reaches wake_ns, another parked worker's time is
+// reached, clock_wake_parked() is called or timeout_ns (real) passes,
+// whichever is first. Returns at once if the clock is already there, or
+// if 'watch' (may be NULL) no longer holds watch_seen.
+void clock_park( struct SysClock *sys_clock, long long wake_ns, long long timeout_ns, const unsigned int *watch,
+                 unsigned int watch_seen );
+
+// Wake every parked worker now, whatever time it waits for; a no-op
+// when nobody is parked
+void clock_wake_parked( struct SysClock *sys_clock );
+
+// Current CLOCK_MONOTONIC time in nanoseconds (real time, not simulated)
+long long monotonic_ns( void );
+
 #endif
@@ -0,0 +1,409 @@
+// dispatch.c
+
+#include "dispatch.h"
+#include "doorbell.h"
+#include "evcal.h"
+#include "shared.h"
+#include "spscq.h"
+#include "wsdeque.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+// Longest a dispatcher sleeps (waiting for a reply, for work or for the
+// clock) before it rechecks its flags
+#define REPLY_POLL_NS 1000000LL
+#define IDLE_WAIT_NS  1000000LL
+
+// Admissions in flight never exceed the PCB slots
+#define ADMISSION_SLOTS 32
+
+struct Dispatcher {
+    // Published to the main loop
+    _Alignas(64) long long local_ns;  // sim time this dispatcher has reached
+    long long next_wakeup_ns;           // earliest calendar entry, -1 if none
+    int idle;                           // asleep with nothing to run or steal
+
+    struct WsDeque ready[MLFQ_LEVELS];  // stolen from by the other dispatchers
+    struct SpscQueue admissions;        // main loop -> this dispatcher (slot numbers)
+
+    // Owner only (read by the main loop after the join)
+    _Alignas(64) long long now_ns;
+    struct EventCalendar calendar;
+    unsigned int boost_seen;
+    struct SchedStats stats;
+    unsigned long long steals;
+    int id;
+    pthread_t thread;
+};
+
+static struct Dispatcher dispatchers[MAX_PROCESSES];
+static int dispatcher_total = 0;
+static int started = 0;
+static struct SharedSegment *segment = NULL;
+
+// Per slot, written by whichever dispatcher holds the slot (a steal hands
+// them over with the deque's CAS)
+static int slot_level[MAX_PROCESSES];
+static long long slot_ready_ns[MAX_PROCESSES];  // holder's sim time when it became ready
+static unsigned int slot_boost[MAX_PROCESSES];  // boost epoch its level belongs to
+static unsigned int slot_reply_seen[MAX_PROCESSES];
+static int slot_state[MAX_PROCESSES];           // enum PcbState, read by the main loop
+
+// Handshake with the main loop
+static int slot_gone[MAX_PROCESSES];     // the worker was reaped
+static int slot_retired[MAX_PROCESSES];  // no dispatcher holds the slot
+
+static unsigned int work_seq = 0;  // futex: bumped when work appears or the clock moves
+static int sleepers = 0;           // dispatchers waiting on work_seq
+static unsigned int progress = 0;  // futex: bumped after every quantum and on going idle
+static int main_waiting = 0;
+static unsigned int boost_epoch = 0;
+static int stopping = 0;
+
+// Main loop only
+static long long last_boost_ns = 0;
+static unsigned long long boost_count = 0;
+static long long idle_total_ns = 0;
+
+static long long sim_now(void) {
+    int sec, nano;
+    read_clock(&segment->clock, &sec, &nano);
+    return (long long)sec * 1000000000LL + nano;
+}
+
+static void notify_work(int everyone) {
+    __atomic_add_fetch(&work_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sleepers, __ATOMIC_SEQ_CST) > 0) futex_wake(&work_seq, everyone ? INT_MAX : 1);
+}
+
+// 'seen' is work_seq from before the caller looked for work, so anything
+// published since then ends the wait at once
+static void wait_for_work(unsigned int seen, long long timeout_ns) {
+    __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+    futex_wait(&work_seq, seen, timeout_ns);
+    __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+}
+
+static void notify_progress(void) {
+    __atomic_add_fetch(&progress, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&main_waiting, __ATOMIC_SEQ_CST)) futex_wake(&progress, 1);
+}
+
+static void publish_local(struct Dispatcher *me) {
+    __atomic_store_n(&me->local_ns, me->now_ns, __ATOMIC_RELEASE);
+}
+
+static void retire(int slot) {
+    __atomic_store_n(&slot_state[slot], PCB_STOPPING, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot_retired[slot], 1, __ATOMIC_RELEASE);
+}
+
+static void make_ready(struct Dispatcher *me, int slot) {
+    // A boost that happened while it was blocked or running still counts
+    unsigned int epoch = __atomic_load_n(&boost_epoch, __ATOMIC_ACQUIRE);
+    if (slot_boost[slot] != epoch) {
+        slot_boost[slot] = epoch;
+        slot_level[slot] = 0;
+    }
+    slot_ready_ns[slot] = me->now_ns;
+    __atomic_store_n(&slot_state[slot], PCB_READY, __ATOMIC_RELAXED);
+    wsdeque_push(&me->ready[slot_level[slot]], slot);
+    notify_work(0);
+}
+
+static void take_admissions(struct Dispatcher *me) {
+    int slot;
+    while (spsc_pop(&me->admissions, &slot)) {
+        slot_level[slot]      = 0;
+        slot_boost[slot]      = __atomic_load_n(&boost_epoch, __ATOMIC_ACQUIRE);
+        slot_reply_seen[slot] = 0;
+        make_ready(me, slot);
+    }
+}
+
+// Everything on this dispatcher's lower levels goes back to level 0
+static void apply_boost(struct Dispatcher *me) {
+    unsigned int epoch = __atomic_load_n(&boost_epoch, __ATOMIC_ACQUIRE);
+    if (epoch == me->boost_seen) return;
+    me->boost_seen = epoch;
+    for (int l = 1; l < MLFQ_LEVELS; l++) {
+        int slot;
+        while ((slot = wsdeque_pop(&me->ready[l])) != WSDEQUE_EMPTY) {
+            slot_level[slot] = 0;
+            slot_boost[slot] = epoch;
+            wsdeque_push(&me->ready[0], slot);
+        }
+    }
+}
+
+static void wake_due(struct Dispatcher *me) {
+    struct CalendarEvent ev;
+    while (calendar_pop_due(&me->calendar, me->now_ns, &ev)) {
+        make_ready(me, ev.slot);
+    }
+    const struct CalendarEvent *next = calendar_peek(&me->calendar);
+    __atomic_store_n(&me->next_wakeup_ns, next ? next->time_ns : -1, __ATOMIC_RELEASE);
+}
+
+// Highest level first, oldest first within a level. The owner takes from
+// the steal end of its own deques too, so each level stays round-robin.
+static int take_ready(struct Dispatcher *me) {
+    for (int l = 0; l < MLFQ_LEVELS; l++) {
+        int slot;
+        while ((slot = wsdeque_steal(&me->ready[l])) == WSDEQUE_ABORT) {
+        }
+        if (slot >= 0) return slot;
+    }
+    for (int i = 1; i < dispatcher_total; i++) {
+        struct Dispatcher *victim = &dispatchers[(me->id + i) % dispatcher_total];
+        for (int l = 0; l < MLFQ_LEVELS; l++) {
+            int slot = wsdeque_steal(&victim->ready[l]);
+            if (slot >= 0) {
+                me->steals++;
+                return slot;
+            }
+        }
+    }
+    return -1;
+}
+
+static void run_quantum(struct Dispatcher *me, int slot) {
+    int level = slot_level[slot];
+    // Stolen from a dispatcher that is ahead: it cannot run before it was ready
+    if (slot_ready_ns[slot] > me->now_ns) me->now_ns = slot_ready_ns[slot];
+
+    me->stats.dispatches++;
+    me->stats.level_dispatches[level]++;
+    me->now_ns += DISPATCH_OVERHEAD_NS;
+    publish_local(me);
+    __atomic_store_n(&slot_state[slot], PCB_RUNNING, __ATOMIC_RELAXED);
+    post_dispatch(segment, slot, MLFQ_BASE_QUANTUM_NS << level);
+
+    while (!wait_dispatch_reply(segment, slot, &slot_reply_seen[slot], REPLY_POLL_NS)) {
+        // Killed mid-quantum, or oss is shutting down
+        if (__atomic_load_n(&slot_gone[slot], __ATOMIC_ACQUIRE)) {
+            retire(slot);
+            return;
+        }
+        if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) return;
+    }
+
+    const struct WorkerReply *r = &segment->replies[slot];
+    long long used_ns = r->used_ns > 0 ? r->used_ns : 0;
+    me->now_ns += used_ns;
+    me->stats.busy_ns += used_ns;
+    switch (r->outcome) {
+    case DISPATCH_BLOCKED:
+        me->stats.blocks++;
+        __atomic_store_n(&slot_state[slot], PCB_BLOCKED, __ATOMIC_RELAXED);
+        calendar_push(&me->calendar, me->now_ns + r->block_ns, EV_WAKEUP, slot, 0, 0);
+        break;
+    case DISPATCH_EXITED:
+        me->stats.exits++;
+        retire(slot);
+        break;
+    default:
+        me->stats.preemptions++;
+        if (level < MLFQ_LEVELS - 1) slot_level[slot] = level + 1;
+        make_ready(me, slot);
+        break;
+    }
+    publish_local(me);
+    notify_progress();
+}
+
+static void *dispatcher_main(void *arg) {
+    struct Dispatcher *me = arg;
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        unsigned int seen = __atomic_load_n(&work_seq, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&me->idle, 0, __ATOMIC_SEQ_CST);
+
+        // Time with nothing to run passes with the global clock
+        long long clock_ns = sim_now();
+        if (me->now_ns < clock_ns) me->now_ns = clock_ns;
+        publish_local(me);
+
+        take_admissions(me);
+        apply_boost(me);
+        wake_due(me);
+
+        // Too far ahead of the slowest busy dispatcher: let the clock catch up
+        if (me->now_ns > clock_ns + DISPATCH_SKEW_NS) {
+            wait_for_work(seen, IDLE_WAIT_NS);
+            continue;
+        }
+
+        int slot = take_ready(me);
+        if (slot < 0) {
+            // Declare idle, then look once more: an admission posted before
+            // the main loop saw the flag must not be slept through
+            __atomic_store_n(&me->idle, 1, __ATOMIC_SEQ_CST);
+            take_admissions(me);
+            slot = take_ready(me);
+            if (slot < 0) {
+                notify_progress();
+                wait_for_work(seen, IDLE_WAIT_NS);
+                continue;
+            }
+            __atomic_store_n(&me->idle, 0, __ATOMIC_SEQ_CST);
+        }
+
+        if (__atomic_load_n(&slot_gone[slot], __ATOMIC_ACQUIRE)) {
+            retire(slot);
+            continue;
+        }
+        run_quantum(me, slot);
+    }
+    return NULL;
+}
+
+int dispatch_start(struct SharedSegment *seg, int k) {
+    if (k < 1 || k > MAX_PROCESSES) return -1;
+    segment          = seg;
+    dispatcher_total = k;
+    for (int s = 0; s < MAX_PROCESSES; s++) {
+        slot_retired[s] = 1;
+    }
+    for (int d = 0; d < k; d++) {
+        struct Dispatcher *me = &dispatchers[d];
+        memset(me, 0, sizeof(*me));
+        me->id             = d;
+        me->idle           = 1;
+        me->next_wakeup_ns = -1;
+        for (int l = 0; l < MLFQ_LEVELS; l++) {
+            wsdeque_init(&me->ready[l]);
+        }
+        calendar_init(&me->calendar);
+        if (spsc_init(&me->admissions, ADMISSION_SLOTS, sizeof(int)) == -1) {
+            perror("dispatcher queue");
+            return -1;
+        }
+    }
+    for (int d = 0; d < k; d++) {
+        int err = pthread_create(&dispatchers[d].thread, NULL, dispatcher_main, &dispatchers[d]);
+        if (err != 0) {
+            fprintf(stderr, "pthread_create dispatcher %d: %s\n", d, strerror(err));
+            dispatcher_total = d;  // stop only what is running
+            started          = 1;
+            dispatch_stop();
+            return -1;
+        }
+    }
+    started = 1;
+    return 0;
+}
+
+void dispatch_admit(int slot) {
+    struct Dispatcher *home = &dispatchers[slot % dispatcher_total];
+    __atomic_store_n(&slot_gone[slot], 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot_retired[slot], 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot_state[slot], PCB_READY, __ATOMIC_RELAXED);
+    if (!spsc_push(&home->admissions, &slot)) {
+        fprintf(stderr, "OSS: dispatcher %d admission queue full, slot %d dropped\n", home->id, slot);
+        __atomic_store_n(&slot_retired[slot], 1, __ATOMIC_RELEASE);
+        return;
+    }
+    // Not idle any more as far as the clock is concerned (see dispatcher_main)
+    __atomic_store_n(&home->idle, 0, __ATOMIC_SEQ_CST);
+    notify_work(1);
+}
+
+void dispatch_advance_clock(struct SysClock *clk, long long next_spawn_ns, long long idle_step_ns,
+                            long long wait_ns) {
+    unsigned int seen = __atomic_load_n(&progress, __ATOMIC_SEQ_CST);
+    long long now_ns  = (long long)clk->sec * 1000000000LL + clk->nano;
+
+    long long busy_min = LLONG_MAX;
+    long long next_ns  = -1;
+    for (int d = 0; d < dispatcher_total; d++) {
+        const struct Dispatcher *disp = &dispatchers[d];
+        if (!__atomic_load_n(&disp->idle, __ATOMIC_SEQ_CST)) {
+            long long local = __atomic_load_n(&disp->local_ns, __ATOMIC_ACQUIRE);
+            if (local < busy_min) busy_min = local;
+        } else {
+            long long wake = __atomic_load_n(&disp->next_wakeup_ns, __ATOMIC_ACQUIRE);
+            if (wake >= 0 && (next_ns < 0 || wake < next_ns)) next_ns = wake;
+        }
+    }
+
+    if (busy_min != LLONG_MAX) {
+        if (busy_min > now_ns) {
+            increment_clock(clk, busy_min - now_ns);
+            notify_work(1);
+        } else {
+            // The slowest dispatcher is mid-quantum: sleep until somebody finishes one
+            __atomic_store_n(&main_waiting, 1, __ATOMIC_SEQ_CST);
+            futex_wait(&progress, seen, wait_ns);
+            __atomic_store_n(&main_waiting, 0, __ATOMIC_RELAXED);
+        }
+    } else {
+        // Everyone idle: skip ahead to whatever happens next
+        if (next_spawn_ns >= 0 && (next_ns < 0 || next_spawn_ns < next_ns)) next_ns = next_spawn_ns;
+        long long step = next_ns > now_ns ? next_ns - now_ns : idle_step_ns;
+        increment_clock(clk, step);
+        idle_total_ns += step;
+        notify_work(1);
+    }
+
+    now_ns = (long long)clk->sec * 1000000000LL + clk->nano;
+    if (now_ns - last_boost_ns >= MLFQ_BOOST_NS) {
+        last_boost_ns = now_ns;
+        boost_count++;
+        __atomic_add_fetch(&boost_epoch, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void dispatch_release(int slot) {
+    __atomic_store_n(&slot_gone[slot], 1, __ATOMIC_RELEASE);
+}
+
+int dispatch_retired(int slot) {
+    return __atomic_load_n(&slot_retired[slot], __ATOMIC_ACQUIRE);
+}
+
+int dispatch_slot_state(int slot) {
+    return __atomic_load_n(&slot_state[slot], __ATOMIC_RELAXED);
+}
+
+void dispatch_stop(void) {
+    if (!started) return;
+    __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+    notify_work(1);
+    for (int d = 0; d < dispatcher_total; d++) {
+        pthread_join(dispatchers[d].thread, NULL);
+        calendar_free(&dispatchers[d].calendar);
+        spsc_free(&dispatchers[d].admissions);
+    }
+    for (int s = 0; s < MAX_PROCESSES; s++) {
+        slot_retired[s] = 1;
+    }
+    started = 0;
+}
+
+int dispatch_count(void) {
+    return dispatcher_total;
+}
+
+void dispatch_thread_stats(int d, struct SchedStats *out, unsigned long long *steals) {
+    *out    = dispatchers[d].stats;
+    *steals = dispatchers[d].steals;
+}
+
+void dispatch_totals(struct SchedStats *out) {
+    memset(out, 0, sizeof(*out));
+    for (int d = 0; d < dispatcher_total; d++) {
+        const struct SchedStats *st = &dispatchers[d].stats;
+        out->dispatches += st->dispatches;
+        for (int l = 0; l < MLFQ_LEVELS; l++) {
+            out->level_dispatches[l] += st->level_dispatches[l];
+        }
+        out->preemptions += st->preemptions;
+        out->blocks += st->blocks;
+        out->exits += st->exits;
+        out->busy_ns += st->busy_ns;
+    }
+    out->boosts  = boost_count;
+    out->idle_ns = idle_total_ns;
+}
@@ -0,0 +1,65 @@
+// dispatch.h
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "clock.h"
+#include "mlfq.h"
+#include "segment.h"
+
+/*
+ * Sharded dispatchers for oss -K. K threads each run the MLFQ policy of
+ * mlfq.h over a shard of the process table. A new worker is admitted to
+ * the dispatcher of slot % K. That dispatcher keeps its ready workers on
+ * one Chase-Lev deque per level (wsdeque.h) and its blocked ones on its
+ * own event calendar. A dispatcher with nothing ready steals the oldest
+ * worker from another dispatcher's highest non-empty level, and the
+ * worker stays with the thief from then on.
+ *
+ * Every dispatcher keeps a local sim time, charged with what its workers
+ * use. SysClock stays global and only the main loop writes it. It moves
+ * the clock up to the earliest local time among the busy dispatchers,
+ * and a dispatcher more than DISPATCH_SKEW_NS ahead of the clock waits.
+ * The periodic boost is a global epoch that each dispatcher applies to
+ * its own deques, and to blocked workers as they wake.
+ *
+ * A slot is held by exactly one dispatcher from admission until it
+ * retires the slot (the worker exited, or was reaped by oss). oss frees
+ * a reaped slot only once it has retired.
+ */
+
+#define DISPATCH_SKEW_NS 50000000LL  // 50 ms sim
+
+// Start k dispatcher threads (1 <= k <= MAX_PROCESSES) over 'seg'
+int dispatch_start( struct SharedSegment *seg, int k );
+
+// Main loop: a worker was launched into 'slot'; it joins level 0 of its home dispatcher
+void dispatch_admit( int slot );
+
+// Main loop, in place of the clock tick. Advances SysClock to the earliest
+// local time of the busy dispatchers, waiting up to wait_ns for one of
+// them to make progress. When all of them are idle it jumps to the next
+// wakeup or to next_spawn_ns (-1 if none), or by idle_step_ns.
+void dispatch_advance_clock( struct SysClock *clk, long long next_spawn_ns, long long idle_step_ns,
+                             long long wait_ns );
+
+// Main loop: the worker in 'slot' was reaped; its dispatcher retires the slot
+void dispatch_release( int slot );
+
+// 1 once no dispatcher holds 'slot'
+int dispatch_retired( int slot );
+
+// Scheduling state of 'slot' as an enum PcbState
+int dispatch_slot_state( int slot );
+
+// Stop and join the dispatchers; afterwards every slot counts as retired
+void dispatch_stop( void );
+
+// After dispatch_stop(): the number of dispatchers, one dispatcher's
+// counters and how many workers it stole, and all of them summed (boosts
+// and idle time are global)
+int dispatch_count( void );
+void dispatch_thread_stats( int d, struct SchedStats *out, unsigned long long *steals );
+void dispatch_totals( struct SchedStats *out );
+
+#endif /* DISPATCH_H */
@@ -0,0 +1,180 @@
+// doorbell.c
+
+#include "doorbell.h"
+#include "shared.h"
+#include <limits.h>
+
+// Mark 'command' pending on one channel; the caller rings the doorbell
+// afterwards. Commands are bits, so a later post never overwrites an
+// earlier one the worker has not taken yet.
+static void write_channel(struct SharedSegment *seg, int slot, int command) {
+    struct WorkerChannel *ch = &seg->channels[slot];
+    __atomic_fetch_or(&ch->pending, 1u << command, __ATOMIC_SEQ_CST);
+    // seq_cst so the 'parked' check below cannot be ordered before it
+    __atomic_add_fetch(&ch->seq, 1u, __ATOMIC_SEQ_CST);
+}
+
+// Wake a worker sleeping on its channel (doorbell_wait)
+static void wake_parked(struct SharedSegment *seg, int slot) {
+    struct WorkerChannel *ch = &seg->channels[slot];
+    if (__atomic_load_n(&ch->parked, __ATOMIC_SEQ_CST)) futex_wake(&ch->seq, 1);
+}
+
+// Nobody sleeps on the doorbell itself: free-running workers park on the
+// clock and check the doorbell before they sleep, so wake them there
+static void ring_doorbell(struct SharedSegment *seg) {
+    __atomic_add_fetch(&seg->doorbell, 1, __ATOMIC_SEQ_CST);
+    clock_wake_parked(&seg->clock);
+}
+
+void post_command(struct SharedSegment *seg, int slot, int command) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return;
+    write_channel(seg, slot, command);
+    ring_doorbell(seg);
+    wake_parked(seg, slot);
+}
+
+void broadcast_command(struct SharedSegment *seg, const int *occupied, int command) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (occupied[i]) write_channel(seg, i, command);
+    }
+    ring_doorbell(seg);
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (occupied[i]) wake_parked(seg, i);
+    }
+}
+
+void post_dispatch(struct SharedSegment *seg, int slot, long long quantum_ns) {
+    // oss posts the next dispatch only after the reply to this one, so the
+    // worker has read quantum_ns by the time it is written again
+    __atomic_store_n(&seg->channels[slot].quantum_ns, quantum_ns, __ATOMIC_RELAXED);
+    write_channel(seg, slot, CMD_DISPATCH);
+    wake_parked(seg, slot);
+}
+
+int wait_dispatch_reply(struct SharedSegment *seg, int slot, unsigned int *seen_seq, long long timeout_ns) {
+    struct WorkerReply *r = &seg->replies[slot];
+    if (timeout_ns > 0 && __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) == *seen_seq) {
+        __atomic_store_n(&r->oss_parked, 1u, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&r->seq, __ATOMIC_SEQ_CST) == *seen_seq) futex_wait(&r->seq, *seen_seq, timeout_ns);
+        __atomic_store_n(&r->oss_parked, 0u, __ATOMIC_RELAXED);
+    }
+    unsigned int seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+    if (seq == *seen_seq) return 0;
+    *seen_seq = seq;
+    return 1;
+}
+
+void reset_channel(struct SharedSegment *seg, int slot) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return;
+    seg->channels[slot].pending    = 0;
+    seg->channels[slot].quantum_ns = 0;
+    seg->channels[slot].parked     = 0;
+    __atomic_store_n(&seg->channels[slot].seq, 0u, __ATOMIC_RELEASE);
+    seg->replies[slot].outcome    = 0;
+    seg->replies[slot].oss_parked = 0;
+    __atomic_store_n(&seg->replies[slot].seq, 0u, __ATOMIC_RELEASE);
+}
+
+void doorbell_reader_init(struct DoorbellReader *reader, const struct SharedSegment *seg) {
+    // Force a look at the channel on the first poll: a command may have
+    // been posted between the fork and our attach.
+    reader->seen_doorbell = __atomic_load_n(&seg->doorbell, __ATOMIC_ACQUIRE) - 1;
+    reader->seen_seq      = 0;
+}
+
+// Take one of the commands in 'bits' off the channel, most urgent first
+static int take_command(struct WorkerChannel *ch, unsigned int bits, long long *arg) {
+    static const int order[] = { CMD_TERMINATE, CMD_REPORT, CMD_DISPATCH };
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        unsigned int bit = 1u << order[i];
+        if (!(bits & bit)) continue;
+        __atomic_fetch_and(&ch->pending, ~bit, __ATOMIC_ACQ_REL);
+        *arg = order[i] == CMD_DISPATCH ? __atomic_load_n(&ch->quantum_ns, __ATOMIC_RELAXED) : 0;
+        return order[i];
+    }
+    return CMD_NONE;
+}
+
+int doorbell_poll(struct DoorbellReader *reader, struct SharedSegment *seg, int slot, long long *arg) {
+    unsigned int bell = __atomic_load_n(&seg->doorbell, __ATOMIC_ACQUIRE);
+    if (bell == reader->seen_doorbell || slot < 0 || slot >= MAX_PROCESSES) return CMD_NONE;
+
+    struct WorkerChannel *ch = &seg->channels[slot];
+    unsigned int bits = __atomic_load_n(&ch->pending, __ATOMIC_ACQUIRE);
+    // With more than one command pending, leave the doorbell unseen so
+    // the next poll takes the next one
+    if ((bits & (bits - 1)) == 0) reader->seen_doorbell = bell;
+    if (bits == 0) return CMD_NONE;  // someone else's command
+    reader->seen_seq = __atomic_load_n(&ch->seq, __ATOMIC_ACQUIRE);
+    return take_command(ch, bits, arg);
+}
+
+int doorbell_wait(struct DoorbellReader *reader, struct SharedSegment *seg, int slot, long long *arg,
+                  long long timeout_ns) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return CMD_NONE;
+    struct WorkerChannel *ch = &seg->channels[slot];
+    unsigned int seq  = __atomic_load_n(&ch->seq, __ATOMIC_ACQUIRE);
+    unsigned int bits = __atomic_load_n(&ch->pending, __ATOMIC_ACQUIRE);
+    if (bits == 0) {
+        // Park, then re-check so a post between the load and the wait is not lost
+        __atomic_store_n(&ch->parked, 1u, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ch->pending, __ATOMIC_SEQ_CST) == 0) futex_wait(&ch->seq, seq, timeout_ns);
+        __atomic_store_n(&ch->parked, 0u, __ATOMIC_RELAXED);
+        bits = __atomic_load_n(&ch->pending, __ATOMIC_ACQUIRE);
+        if (bits == 0) return CMD_NONE;
+    }
+    reader->seen_seq      = __atomic_load_n(&ch->seq, __ATOMIC_ACQUIRE);
+    reader->seen_doorbell = __atomic_load_n(&seg->doorbell, __ATOMIC_ACQUIRE);
+    return take_command(ch, bits, arg);
+}
+
+// Publish a filled-in reply line and wake oss if it waits for it
+static void publish_reply(struct WorkerReply *r) {
+    __atomic_store_n(&r->seq, r->seq + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->oss_parked, __ATOMIC_SEQ_CST)) futex_wake(&r->seq, 1);
+}
+
+// Fill in the reply line and publish it
+static void write_reply(struct SharedSegment *seg, int slot, int outcome, long long used_ns, long long block_ns,
+                        int resource, int count) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return;
+    struct WorkerReply *r = &seg->replies[slot];
+    r->outcome  = outcome;
+    r->used_ns  = used_ns;
+    r->block_ns = block_ns;
+    r->resource = resource;
+    r->count    = count;
+    publish_reply(r);
+}
+
+void post_dispatch_reply(struct SharedSegment *seg, int slot, int outcome, long long used_ns, long long block_ns) {
+    write_reply(seg, slot, outcome, used_ns, block_ns, -1, 0);
+}
+
+void post_resource_reply(struct SharedSegment *seg, int slot, int outcome, long long used_ns, int resource,
+                         int count) {
+    write_reply(seg, slot, outcome, used_ns, 0, resource, count);
+}
+
+void post_memory_reply(struct SharedSegment *seg, int slot, long long used_ns, unsigned int address, int write) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return;
+    struct WorkerReply *r = &seg->replies[slot];
+    r->outcome  = DISPATCH_MEMORY;
+    r->used_ns  = used_ns;
+    r->block_ns = 0;
+    r->address  = address;
+    r->write    = write;
+    publish_reply(r);
+}
+
+void post_io_reply(struct SharedSegment *seg, int slot, long long used_ns, int device, int cylinder) {
+    if (slot < 0 || slot >= MAX_PROCESSES) return;
+    struct WorkerReply *r = &seg->replies[slot];
+    r->outcome  = DISPATCH_IO;
+    r->used_ns  = used_ns;
+    r->block_ns = 0;
+    r->device   = device;
+    r->cylinder = cylinder;
+    publish_reply(r);
+}
@@ -0,0 +1,72 @@
+// doorbell.h
+
+#ifndef DOORBELL_H
+#define DOORBELL_H
+
+#include "segment.h"
+
+/*
+ * oss -> worker command channel. Each PCB slot has a word of pending
+ * command bits in the segment; posting a command sets its bit and then
+ * rings the segment-wide doorbell word. Workers compare the doorbell
+ * with the value they last saw on every clock check, so one store
+ * reaches every polling worker no matter how many there are. Workers
+ * parked on the clock (oss -W) check the doorbell before they sleep,
+ * and ringing it wakes them through the clock's wake word
+ * (clock_wake_parked), so a command never waits out a park. Because commands
+ * are bits, a broadcast (say CMD_REPORT on SIGUSR2) cannot overwrite a
+ * CMD_DISPATCH or CMD_TERMINATE the worker has not taken yet.
+ *
+ * Under the scheduler (oss -m) workers do not poll: they sleep on their
+ * own channel's seq word with 'parked' set, and oss wakes just that
+ * worker after posting. CMD_DISPATCH skips the doorbell entirely, and
+ * the worker answers through its WorkerReply line the same way.
+ */
+
+// oss: clear a slot's channel before launching a worker into it
+void reset_channel( struct SharedSegment *seg, int slot );
+
+// oss: post a command to one slot and ring the doorbell
+void post_command( struct SharedSegment *seg, int slot, int command );
+
+// oss: post the same command to every slot with occupied[slot] != 0, ring once
+void broadcast_command( struct SharedSegment *seg, const int *occupied, int command );
+
+// oss: hand 'slot' a quantum of 'quantum_ns' (targeted wake, no doorbell)
+void post_dispatch( struct SharedSegment *seg, int slot, long long quantum_ns );
+
+// oss: wait up to timeout_ns (real; 0 = just check) for the reply after *seen_seq;
+// returns 1 and advances *seen_seq if one arrived
+int wait_dispatch_reply( struct SharedSegment *seg, int slot, unsigned int *seen_seq, long long timeout_ns );
+
+// Worker-side view of its channel
+struct DoorbellReader {
+  unsigned int seen_doorbell;  // doorbell value at the last check
+  unsigned int seen_seq;       // channel seq when the last command was taken
+};
+
+// worker: start listening; commands posted since oss reset the channel still count
+void doorbell_reader_init( struct DoorbellReader *reader, const struct SharedSegment *seg );
+
+// worker: takes a pending command for 'slot' (*arg is the quantum for CMD_DISPATCH)
+// or returns CMD_NONE. Cheap when nothing changed: a single load of the doorbell word.
+int doorbell_poll( struct DoorbellReader *reader, struct SharedSegment *seg, int slot, long long *arg );
+
+// worker: like doorbell_poll, but sleep on the channel (up to timeout_ns real) until a command arrives
+int doorbell_wait( struct DoorbellReader *reader, struct SharedSegment *seg, int slot, long long *arg,
+                   long long timeout_ns );
+
+// worker: answer a CMD_DISPATCH
+void post_dispatch_reply( struct SharedSegment *seg, int slot, int outcome, long long used_ns, long long block_ns );
+
+// worker: answer a CMD_DISPATCH with DISPATCH_REQUEST or DISPATCH_RELEASE (oss -R)
+void post_resource_reply( struct SharedSegment *seg, int slot, int outcome, long long used_ns, int resource,
+                          int count );
+
+// worker: answer a CMD_DISPATCH with DISPATCH_MEMORY (oss -P)
+void post_memory_reply( struct SharedSegment *seg, int slot, long long used_ns, unsigned int address, int write );
+
+// worker: answer a CMD_DISPATCH with DISPATCH_IO (oss -I)
+void post_io_reply( struct SharedSegment *seg, int slot, long long used_ns, int device, int cylinder );
+
+#endif /* DOORBELL_H */
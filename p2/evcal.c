@@ -0,0 +1,71 @@
+// evcal.c
+
+#include "evcal.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CALENDAR_INITIAL_CAPACITY 64
+
+static int earlier(const struct CalendarEvent *a, const struct CalendarEvent *b) {
+    if (a->time_ns != b->time_ns) return a->time_ns < b->time_ns;
+    return a->order < b->order;
+}
+
+void calendar_init(struct EventCalendar *cal) {
+    cal->heap       = NULL;
+    cal->size       = 0;
+    cal->capacity   = 0;
+    cal->next_order = 0;
+}
+
+void calendar_free(struct EventCalendar *cal) {
+    free(cal->heap);
+    calendar_init(cal);
+}
+
+void calendar_push(struct EventCalendar *cal, long long time_ns, int type, int slot, unsigned int token,
+                   long long arg) {
+    if (cal->size == cal->capacity) {
+        size_t cap = cal->capacity ? cal->capacity * 2 : CALENDAR_INITIAL_CAPACITY;
+        struct CalendarEvent *grown = realloc(cal->heap, cap * sizeof(*grown));
+        if (!grown) {
+            perror("realloc event calendar");
+            exit(EXIT_FAILURE);
+        }
+        cal->heap     = grown;
+        cal->capacity = cap;
+    }
+
+    struct CalendarEvent ev = { time_ns, cal->next_order++, type, slot, token, arg };
+    size_t i = cal->size++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!earlier(&ev, &cal->heap[parent])) break;
+        cal->heap[i] = cal->heap[parent];
+        i = parent;
+    }
+    cal->heap[i] = ev;
+}
+
+const struct CalendarEvent *calendar_peek(const struct EventCalendar *cal) {
+    return cal->size ? &cal->heap[0] : NULL;
+}
+
+int calendar_pop_due(struct EventCalendar *cal, long long now_ns, struct CalendarEvent *out) {
+    if (cal->size == 0 || cal->heap[0].time_ns > now_ns) return 0;
+    *out = cal->heap[0];
+
+    // Sift the last event down from the root
+    struct CalendarEvent last = cal->heap[--cal->size];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= cal->size) break;
+        if (child + 1 < cal->size && earlier(&cal->heap[child + 1], &cal->heap[child])) child++;
+        if (!earlier(&cal->heap[child], &last)) break;
+        cal->heap[i] = cal->heap[child];
+        i = child;
+    }
+    if (cal->size) cal->heap[i] = last;
+    return 1;
+}
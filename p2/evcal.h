@@ -0,0 +1,50 @@
+// evcal.h
+
+#ifndef EVCAL_H
+#define EVCAL_H
+
+#include <stddef.h>
+
+/*
+ * Event calendar: a binary min-heap of future events keyed by sim time.
+ * Events at the same time pop in the order they were scheduled. oss
+ * uses it for blocked workers' wakeups; anything that completes at a
+ * known sim time can be scheduled here.
+ */
+
+enum CalendarEventType {
+  EV_WAKEUP = 1,    // a blocked worker becomes ready
+  EV_IO_COMPLETE,   // an I/O device finished a request (arg: device, iodev.h)
+  EV_TYPE_COUNT
+};
+
+struct CalendarEvent {
+  long long time_ns;        // sim time the event fires
+  unsigned long long order; // insertion number, breaks ties FIFO
+  int type;                 // enum CalendarEventType
+  int slot;                 // PCB slot the event is about
+  unsigned int token;       // lets the owner recognize stale events
+  long long arg;            // event-specific
+};
+
+struct EventCalendar {
+  struct CalendarEvent *heap;
+  size_t size;
+  size_t capacity;
+  unsigned long long next_order;
+};
+
+void calendar_init( struct EventCalendar *cal );
+void calendar_free( struct EventCalendar *cal );
+
+// Schedule an event (the heap grows as needed; exits if out of memory)
+void calendar_push( struct EventCalendar *cal, long long time_ns, int type, int slot, unsigned int token,
+                    long long arg );
+
+// Earliest event without removing it, or NULL if the calendar is empty
+const struct CalendarEvent *calendar_peek( const struct EventCalendar *cal );
+
+// Remove the earliest event into *out if it fires at or before now_ns; returns 1 if one was removed
+int calendar_pop_due( struct EventCalendar *cal, long long now_ns, struct CalendarEvent *out );
+
+#endif /* EVCAL_H */
@@ -0,0 +1,43 @@
+// hist.c
+
+#include "hist.h"
+#include <limits.h>
+
+static int bucket_of(unsigned long long v) {
+    if (v < HIST_SUB_BUCKETS) return (int)v;
+    int exp = 63 - __builtin_clzll(v);
+    return (exp - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS + (int)(v >> (exp - HIST_SUB_BITS)) - HIST_SUB_BUCKETS;
+}
+
+// Largest value that lands in bucket b
+static long long bucket_upper(int b) {
+    if (b < HIST_SUB_BUCKETS) return b;
+    int exp = b / HIST_SUB_BUCKETS + HIST_SUB_BITS - 1;
+    unsigned long long sub = (unsigned long long)(b % HIST_SUB_BUCKETS + HIST_SUB_BUCKETS);
+    unsigned long long upper = ((sub + 1) << (exp - HIST_SUB_BITS)) - 1;
+    return upper > (unsigned long long)LLONG_MAX ? LLONG_MAX : (long long)upper;
+}
+
+void hist_record(struct LatencyHist *h, long long value) {
+    if (value < 0) value = 0;
+    if (h->count == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->count++;
+    h->buckets[bucket_of((unsigned long long)value)]++;
+}
+
+long long hist_percentile(const struct LatencyHist *h, double p) {
+    if (h->count == 0) return 0;
+    unsigned long long rank = (unsigned long long)(p / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > h->count) rank = h->count;
+    unsigned long long seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            long long v = bucket_upper(b);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
@@ -0,0 +1,68 @@
+// hist.h
+
+#ifndef HIST_H
+#define HIST_H
+
+/*
+ * Log-linear latency histograms (HDR style). Values are bucketed by
+ * their power of two, and each power of two is split into
+ * HIST_SUB_BUCKETS linear steps, so a bucket is never wider than 1/16
+ * of its value. Recording is a count-leading-zeros and an increment,
+ * cheap enough to leave on in the oss loop.
+ */
+
+#define HIST_SUB_BITS    4
+#define HIST_SUB_BUCKETS ( 1 << HIST_SUB_BITS )
+#define HIST_BUCKETS     ( ( 64 - HIST_SUB_BITS + 1 ) * HIST_SUB_BUCKETS )
+
+// The intervals oss keeps histograms for
+enum LatencyKind {
+  LAT_SPAWN_ATTACH = 0,  // spawn decision in stage (E) -> worker attached (real ns)
+  LAT_EXIT_REAP,         // worker exit -> waitpid() in oss (real ns)
+  LAT_OVERSHOOT,         // past end_sec/end_nano when the worker noticed (sim ns)
+  LAT_TICK_GAP,          // between consecutive clock advances in the oss loop (real ns)
+  LAT_KIND_COUNT
+};
+
+// Resource usage of reaped workers, from wait4()
+enum UsageKind {
+  USAGE_USER_CPU = 0,  // user CPU time (us)
+  USAGE_SYS_CPU,       // system CPU time (us)
+  USAGE_MAX_RSS,       // peak resident set (KiB)
+  USAGE_VOL_CSW,       // voluntary context switches (blocked on a futex, a pipe, ...)
+  USAGE_INVOL_CSW,     // involuntary context switches (preempted)
+  USAGE_KIND_COUNT
+};
+
+struct LatencyHist {
+  unsigned long long count;
+  long long min;
+  long long max;
+  unsigned long long buckets[HIST_BUCKETS];
+};
+
+// Add one sample (negative values count as 0)
+void hist_record( struct LatencyHist *h, long long value );
+
+// Value at percentile p (0-100), as the upper edge of its bucket capped at max
+long long hist_percentile( const struct LatencyHist *h, double p );
+
+// Short name of an enum LatencyKind value
+static inline const char *latency_kind_name( int kind ) {
+  static const char *names[LAT_KIND_COUNT] = { "spawn->attach", "exit->reap", "overshoot", "tick gap" };
+  return kind >= 0 && kind < LAT_KIND_COUNT ? names[kind] : "?";
+}
+
+// Short name and unit of an enum UsageKind value
+static inline const char *usage_kind_name( int kind ) {
+  static const char *names[USAGE_KIND_COUNT] = { "user cpu", "sys cpu", "max rss", "voluntary csw",
+                                                 "involuntary csw" };
+  return kind >= 0 && kind < USAGE_KIND_COUNT ? names[kind] : "?";
+}
+
+static inline const char *usage_kind_unit( int kind ) {
+  static const char *units[USAGE_KIND_COUNT] = { "us", "us", "KiB", "count", "count" };
+  return kind >= 0 && kind < USAGE_KIND_COUNT ? units[kind] : "count";
+}
+
+#endif /* HIST_H */
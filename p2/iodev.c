@@ -0,0 +1,154 @@
+// iodev.c
+
+#include "iodev.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IO_INITIAL_CAPACITY 16
+
+int io_policy_parse(const char *name) {
+    for (int p = 0; p < IO_POLICY_COUNT; p++) {
+        if (strcmp(name, io_policy_name(p)) == 0) return p;
+    }
+    return -1;
+}
+
+void iodev_init(struct IoDevice *dev, int id, int policy) {
+    memset(dev, 0, sizeof(*dev));
+    dev->id        = id;
+    dev->policy    = policy;
+    dev->direction = 1;
+    dev->seed      = 0x10de5eedu + (unsigned int)id;
+}
+
+void iodev_free(struct IoDevice *dev) {
+    free(dev->queue);
+    dev->queue = NULL;
+    dev->count = dev->capacity = dev->first = 0;
+}
+
+// Index of the first queued request (elevator order) at or above cylinder
+static int lower_bound(const struct IoDevice *dev, int cylinder) {
+    int lo = 0, hi = dev->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (dev->queue[mid].cylinder < cylinder) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Move the queue to a buffer of cap entries, keeping the requests whose
+// slot is not 'drop' (-1 keeps all) and unwrapping a fifo ring to start at 0
+static void relayout(struct IoDevice *dev, int cap, int drop) {
+    struct IoRequest *moved = malloc((size_t)cap * sizeof(*moved));
+    if (!moved) {
+        perror("malloc");
+        exit(1);
+    }
+    int kept = 0;
+    for (int i = 0; i < dev->count; i++) {
+        const struct IoRequest *req = &dev->queue[(dev->first + i) % dev->capacity];
+        if (req->slot != drop) moved[kept++] = *req;
+    }
+    free(dev->queue);
+    dev->queue    = moved;
+    dev->capacity = cap;
+    dev->count    = kept;
+    dev->first    = 0;
+}
+
+static void enqueue(struct IoDevice *dev, const struct IoRequest *req) {
+    if (dev->count == dev->capacity) relayout(dev, dev->capacity ? dev->capacity * 2 : IO_INITIAL_CAPACITY, -1);
+    if (dev->policy == IO_FIFO) {
+        dev->queue[(dev->first + dev->count) % dev->capacity] = *req;
+    } else {
+        // After any request for the same cylinder, so those go in arrival order
+        int at = lower_bound(dev, req->cylinder + 1);
+        memmove(&dev->queue[at + 1], &dev->queue[at], (size_t)(dev->count - at) * sizeof(*req));
+        dev->queue[at] = *req;
+    }
+    dev->count++;
+    if (dev->count > dev->stats.max_queue) dev->stats.max_queue = dev->count;
+}
+
+static struct IoRequest dequeue(struct IoDevice *dev) {
+    struct IoRequest req;
+    if (dev->policy == IO_FIFO) {
+        req        = dev->queue[dev->first];
+        dev->first = (dev->first + 1) % dev->capacity;
+    } else {
+        // Next request in the sweep direction; turn around at the last one
+        int at;
+        if (dev->direction > 0) {
+            at = lower_bound(dev, dev->head);
+            if (at == dev->count) {
+                dev->direction = -1;
+                at = lower_bound(dev, dev->queue[dev->count - 1].cylinder);
+            }
+        } else {
+            at = lower_bound(dev, dev->head + 1) - 1;
+            if (at < 0) {
+                dev->direction = 1;
+                at = 0;
+            } else {
+                at = lower_bound(dev, dev->queue[at].cylinder);
+            }
+        }
+        req = dev->queue[at];
+        memmove(&dev->queue[at], &dev->queue[at + 1], (size_t)(dev->count - at - 1) * sizeof(req));
+    }
+    dev->count--;
+    return req;
+}
+
+// Put a request in service and schedule the event for when it is done
+static void start(struct IoDevice *dev, struct EventCalendar *cal, long long now_ns, const struct IoRequest *req) {
+    // oss may pop a completion after the clock has passed it and queued
+    // more behind it; those cannot start before they were issued
+    if (now_ns < req->issued_ns) now_ns = req->issued_ns;
+    int distance = req->cylinder > dev->head ? req->cylinder - dev->head : dev->head - req->cylinder;
+    long long service = IO_SEEK_NS_PER_CYL * distance + (distance ? IO_SETTLE_NS : 0) +
+                        (long long)rand_r(&dev->seed) % IO_ROTATION_NS + IO_TRANSFER_NS;
+    dev->stats.cylinders += (unsigned long long)distance;
+    dev->stats.wait_ns += now_ns - req->issued_ns;
+    dev->stats.service_ns += service;
+    dev->head    = req->cylinder;
+    dev->busy    = 1;
+    dev->current = *req;
+    calendar_push(cal, now_ns + service, EV_IO_COMPLETE, req->slot, req->token, dev->id);
+}
+
+void iodev_submit(struct IoDevice *dev, struct EventCalendar *cal, long long now_ns, int slot, unsigned int token,
+                  int cylinder) {
+    struct IoRequest req = { slot, token, cylinder, now_ns };
+    dev->stats.requests++;
+    if (dev->busy) {
+        enqueue(dev, &req);
+    } else {
+        start(dev, cal, now_ns, &req);
+    }
+}
+
+void iodev_complete(struct IoDevice *dev, struct EventCalendar *cal, long long now_ns, struct IoRequest *done) {
+    *done     = dev->current;
+    dev->busy = 0;
+    dev->stats.completed++;
+    if (dev->count > 0) {
+        struct IoRequest next = dequeue(dev);
+        start(dev, cal, now_ns, &next);
+    }
+}
+
+void iodev_cancel(struct IoDevice *dev, int slot) {
+    for (int i = 0; i < dev->count; i++) {
+        if (dev->queue[(dev->first + i) % dev->capacity].slot == slot) {
+            relayout(dev, dev->capacity, slot);
+            return;
+        }
+    }
+}
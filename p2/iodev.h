@@ -0,0 +1,93 @@
+// iodev.h
+
+#ifndef IODEV_H
+#define IODEV_H
+
+#include "evcal.h"
+
+/*
+ * Simulated I/O devices for oss -I. Each device serves one request at a
+ * time and queues the rest, in arrival order (fifo) or by cylinder
+ * (elevator: the head sweeps one way serving every request it passes,
+ * then turns around). Service time is seek distance times
+ * IO_SEEK_NS_PER_CYL plus a settle time if the head moved, a uniformly
+ * distributed rotational delay and a fixed transfer time.
+ *
+ * A device never polls. Starting a request schedules an EV_IO_COMPLETE
+ * event on the event calendar for the sim time it will finish; when oss
+ * pops it, iodev_complete() hands back the request and starts the next
+ * one. Devices cost nothing per tick however many requests are queued.
+ */
+
+enum IoPolicy {
+  IO_FIFO = 0,
+  IO_ELEVATOR,
+  IO_POLICY_COUNT
+};
+
+#define IO_MAX_DEVICES     8
+#define IO_CYLINDERS       1000
+#define IO_SEEK_NS_PER_CYL 10000LL    // 10 us per cylinder crossed
+#define IO_SETTLE_NS       1000000LL  // 1 ms once the head has moved
+#define IO_ROTATION_NS     8333333LL  // one turn at 7200 rpm; the delay is uniform over it
+#define IO_TRANSFER_NS     100000LL   // 0.1 ms
+
+// Set by oss -I ("devices:cylinders"); workers then block on I/O
+#define IODEV_ENV "OSS_IODEV"
+
+struct IoRequest {
+  int slot;             // PCB slot that waits for it
+  unsigned int token;   // the PCB's wake_token when it blocked
+  int cylinder;
+  long long issued_ns;  // sim time it was submitted
+};
+
+struct IoStats {
+  unsigned long long requests;
+  unsigned long long completed;
+  unsigned long long cylinders;   // head movement
+  int max_queue;                  // longest queue seen (not counting the one in service)
+  long long wait_ns;              // sim time started requests spent queued
+  long long service_ns;           // sim time spent serving them (busy time)
+};
+
+struct IoDevice {
+  int id;                         // arg of its calendar events
+  int policy;                     // enum IoPolicy
+  int head;                       // cylinder under the head
+  int direction;                  // elevator sweep: 1 up, -1 down
+  int busy;                       // 'current' is in service
+  struct IoRequest current;
+  struct IoRequest *queue;        // fifo: ring from 'first'; elevator: sorted by cylinder
+  int count;
+  int first;
+  int capacity;
+  unsigned int seed;              // rotational delays
+  struct IoStats stats;
+};
+
+static inline const char *io_policy_name( int policy ) {
+  static const char *names[IO_POLICY_COUNT] = { "fifo", "elevator" };
+  return policy >= 0 && policy < IO_POLICY_COUNT ? names[policy] : "?";
+}
+
+// enum IoPolicy for a name, or -1
+int io_policy_parse( const char *name );
+
+void iodev_init( struct IoDevice *dev, int id, int policy );
+void iodev_free( struct IoDevice *dev );
+
+// Queue a request at now_ns; an idle device starts it and schedules its
+// completion on 'cal' (exits if out of memory)
+void iodev_submit( struct IoDevice *dev, struct EventCalendar *cal, long long now_ns, int slot, unsigned int token,
+                   int cylinder );
+
+// The EV_IO_COMPLETE event for this device fired at now_ns: copy the
+// finished request to *done and start the next one, if any
+void iodev_complete( struct IoDevice *dev, struct EventCalendar *cal, long long now_ns, struct IoRequest *done );
+
+// Drop the queued requests of a slot whose worker is gone (one already in
+// service runs to completion and is recognized as stale by its token)
+void iodev_cancel( struct IoDevice *dev, int slot );
+
+#endif /* IODEV_H */
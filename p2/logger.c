@@ -0,0 +1,170 @@
+// logger.c
+
+#include "logger.h"
+#include "spscq.h"
+#include "stageprof.h"
+#include "trace.h"
+#include "tracetext.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define LOGGER_SLOTS      2048  // power of two
+#define LOGGER_BATCH      64    // entries per writev()
+#define LOGGER_IDLE_NS    100000000LL
+
+enum { ENTRY_EVENT, ENTRY_TEXT };
+
+struct LogEntry {
+    int kind;
+    union {
+        struct {
+            struct TraceRecord rec;
+            long long args[TRACE_MAX_ARGS];
+        } event;
+        char text[TRACE_TEXT_MAX];
+    } u;
+};
+
+// oss main thread -> logger thread
+static struct SpscQueue queue;
+
+static int stopping             = 0;
+static unsigned long long dropped = 0;
+static int lossless             = 0;
+static unsigned long long waits = 0;  // lossless mode: times the ring was full
+
+static pthread_t logger_thread;
+static int running = 0;
+
+static void push_entry(const struct LogEntry *e) {
+    if (!spsc_push(&queue, e)) {
+        if (!lossless) {
+            dropped++;
+            return;
+        }
+        // The ring is full, so the consumer is awake and draining it
+        waits++;
+        spsc_push_wait(&queue, e);
+    }
+    // spsc_push paid for a FUTEX_WAKE if the consumer was asleep
+    if (__atomic_load_n(&queue.sleeping, __ATOMIC_RELAXED)) STAGE_SYSCALL();
+}
+
+static void queue_event(const struct TraceRecord *rec, const long long *args) {
+    struct LogEntry e;
+    e.kind        = ENTRY_EVENT;
+    e.u.event.rec = *rec;
+    if (rec->argc > 0) {
+        memcpy(e.u.event.args, args, (size_t)rec->argc * sizeof(long long));
+    }
+    push_entry(&e);
+}
+
+void logger_set_lossless(int on) {
+    lossless = on;
+}
+
+void logger_printf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (!running) {
+        vprintf(fmt, ap);
+    } else {
+        struct LogEntry e;
+        e.kind = ENTRY_TEXT;
+        vsnprintf(e.u.text, sizeof(e.u.text), fmt, ap);
+        push_entry(&e);
+    }
+    va_end(ap);
+}
+
+static void write_all(struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(STDOUT_FILENO, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;  // nowhere to report a broken stdout
+        }
+        // Skip what was written, possibly ending inside an iovec
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+}
+
+static void *logger_main(void *unused) {
+    (void)unused;
+    static struct LogEntry batch[LOGGER_BATCH];
+    static char lines[LOGGER_BATCH][TRACE_TEXT_MAX];
+    struct iovec iov[LOGGER_BATCH];
+
+    while (1) {
+        // Take a batch off the ring, format it, then write it in one go
+        int n = 0;
+        while (n < LOGGER_BATCH && spsc_pop(&queue, &batch[n])) n++;
+        if (n == 0) {
+            if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) break;
+            spsc_wait(&queue, &stopping, LOGGER_IDLE_NS);
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            const struct LogEntry *e = &batch[i];
+            int len;
+            if (e->kind == ENTRY_EVENT) {
+                len = trace_format_text(lines[i], sizeof(lines[i]), &e->u.event.rec, e->u.event.args);
+            } else {
+                len = (int)strnlen(e->u.text, sizeof(e->u.text));
+                memcpy(lines[i], e->u.text, (size_t)len);
+            }
+            iov[i].iov_base = lines[i];
+            iov[i].iov_len  = (size_t)len;
+        }
+        write_all(iov, n);
+    }
+    return NULL;
+}
+
+int logger_start(void) {
+    // Anything already sitting in stdio's buffer goes out first
+    fflush(stdout);
+    if (spsc_init(&queue, LOGGER_SLOTS, sizeof(struct LogEntry)) != 0) {
+        perror("logger queue");
+        return -1;
+    }
+    if (pthread_create(&logger_thread, NULL, logger_main, NULL) != 0) {
+        perror("pthread_create logger");
+        spsc_free(&queue);
+        return -1;
+    }
+    running = 1;
+    trace_set_text_sink(queue_event);
+    return 0;
+}
+
+void logger_stop(void) {
+    if (!running) return;
+    trace_set_text_sink(NULL);
+    __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+    spsc_kick(&queue);
+    pthread_join(logger_thread, NULL);
+    spsc_free(&queue);
+    running = 0;
+    if (dropped) {
+        fprintf(stderr, "OSS: logger dropped %llu entries (ring full)\n", dropped);
+    }
+    if (waits) {
+        fprintf(stderr, "OSS: logger ring full %llu times, oss waited for it\n", waits);
+    }
+}
@@ -0,0 +1,29 @@
+// logger.h
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/*
+ * Asynchronous text output for oss. While the logger is running, text
+ * mode trace events (the process table, counters, ...) and
+ * logger_printf() messages are copied into a single-producer queue
+ * (spscq.h) and a dedicated thread formats them and writes them to stdout
+ * in batches with writev(). By default the producer never blocks: if
+ * the ring is full the entry is dropped and counted. In lossless mode
+ * (oss -L, where the lines are the only record of the tasks) it waits
+ * for the logger thread to free a slot instead.
+ */
+
+// Start the logger thread and route text-mode trace events to it
+int logger_start( void );
+
+// Wait for room instead of dropping when the ring is full (on != 0)
+void logger_set_lossless( int on );
+
+// Queue a formatted message (printf directly if the logger is not running)
+void logger_printf( const char *fmt, ... ) __attribute__( ( format( printf, 1, 2 ) ) );
+
+// Drain everything queued, stop the thread and restore direct output
+void logger_stop( void );
+
+#endif /* LOGGER_H */
@@ -0,0 +1,184 @@
+// mlfq.c
+
+#include "mlfq.h"
+#include "segment.h"
+
+// Append 'slot' to the list (head, tail)
+static void list_push(struct PCB *table, int *head, int *tail, int slot) {
+    table[slot].next = -1;
+    table[slot].prev = *tail;
+    if (*tail >= 0) {
+        table[*tail].next = slot;
+    } else {
+        *head = slot;
+    }
+    *tail = slot;
+}
+
+static void list_unlink(struct PCB *table, int *head, int *tail, int slot) {
+    int prev = table[slot].prev, next = table[slot].next;
+    if (prev >= 0) {
+        table[prev].next = next;
+    } else {
+        *head = next;
+    }
+    if (next >= 0) {
+        table[next].prev = prev;
+    } else {
+        *tail = prev;
+    }
+    table[slot].next = table[slot].prev = -1;
+}
+
+static void make_ready(struct Mlfq *q, int slot) {
+    int level = q->table[slot].level;
+    list_push(q->table, &q->head[level], &q->tail[level], slot);
+    q->ready_bitmap |= 1u << level;
+    q->table[slot].queue = SQ_READY;
+    q->table[slot].state = PCB_READY;
+}
+
+void mlfq_init(struct Mlfq *q, struct PCB *table) {
+    q->table        = table;
+    q->ready_bitmap = 0;
+    for (int l = 0; l < MLFQ_LEVELS; l++) {
+        q->head[l] = q->tail[l] = -1;
+    }
+    q->blocked_head = q->blocked_tail = -1;
+    q->blocked_count = 0;
+    q->last_boost_ns = 0;
+    calendar_init(&q->calendar);
+    q->on_event = NULL;
+    struct SchedStats zero = { 0 };
+    q->stats = zero;
+}
+
+void mlfq_free(struct Mlfq *q) {
+    calendar_free(&q->calendar);
+}
+
+void mlfq_admit(struct Mlfq *q, int slot) {
+    q->table[slot].level      = 0;
+    q->table[slot].service_ns = 0;
+    make_ready(q, slot);
+}
+
+int mlfq_pick(struct Mlfq *q) {
+    if (q->ready_bitmap == 0) return -1;
+    int level = __builtin_ctz(q->ready_bitmap);
+    int slot  = q->head[level];
+    list_unlink(q->table, &q->head[level], &q->tail[level], slot);
+    if (q->head[level] < 0) q->ready_bitmap &= ~(1u << level);
+
+    q->table[slot].queue = SQ_RUNNING;
+    q->table[slot].state = PCB_RUNNING;
+    q->stats.dispatches++;
+    q->stats.level_dispatches[level]++;
+    return slot;
+}
+
+long long mlfq_quantum(const struct Mlfq *q, int slot) {
+    return MLFQ_BASE_QUANTUM_NS << q->table[slot].level;
+}
+
+void mlfq_preempted(struct Mlfq *q, int slot) {
+    if (q->table[slot].level < MLFQ_LEVELS - 1) q->table[slot].level++;
+    q->stats.preemptions++;
+    make_ready(q, slot);
+}
+
+void mlfq_block(struct Mlfq *q, int slot, long long wake_ns) {
+    struct PCB *pcb = &q->table[slot];
+    list_push(q->table, &q->blocked_head, &q->blocked_tail, slot);
+    pcb->queue = SQ_BLOCKED;
+    pcb->state = PCB_BLOCKED;
+    pcb->wake_token++;
+    q->blocked_count++;
+    q->stats.blocks++;
+    calendar_push(&q->calendar, wake_ns, EV_WAKEUP, slot, pcb->wake_token, 0);
+}
+
+void mlfq_wait(struct Mlfq *q, int slot) {
+    struct PCB *pcb = &q->table[slot];
+    list_push(q->table, &q->blocked_head, &q->blocked_tail, slot);
+    pcb->queue = SQ_BLOCKED;
+    pcb->state = PCB_BLOCKED;
+    pcb->wake_token++;  // no calendar event may wake it
+    q->blocked_count++;
+    q->stats.blocks++;
+}
+
+void mlfq_unblock(struct Mlfq *q, int slot) {
+    if (q->table[slot].queue != SQ_BLOCKED) return;
+    list_unlink(q->table, &q->blocked_head, &q->blocked_tail, slot);
+    q->blocked_count--;
+    make_ready(q, slot);
+}
+
+void mlfq_requeue(struct Mlfq *q, int slot) {
+    make_ready(q, slot);
+}
+
+int mlfq_wake_due(struct Mlfq *q, long long now_ns) {
+    int woken = 0;
+    struct CalendarEvent ev;
+    while (calendar_pop_due(&q->calendar, now_ns, &ev)) {
+        if (ev.type != EV_WAKEUP) {
+            if (q->on_event) q->on_event(&ev);
+            continue;
+        }
+        struct PCB *pcb = &q->table[ev.slot];
+        // Stale if the worker was removed (or blocked again) since
+        if (pcb->queue != SQ_BLOCKED || pcb->wake_token != ev.token) continue;
+        list_unlink(q->table, &q->blocked_head, &q->blocked_tail, ev.slot);
+        q->blocked_count--;
+        make_ready(q, ev.slot);
+        woken++;
+    }
+    return woken;
+}
+
+long long mlfq_next_wakeup(const struct Mlfq *q) {
+    const struct CalendarEvent *ev = calendar_peek(&q->calendar);
+    return ev ? ev->time_ns : -1;
+}
+
+void mlfq_remove(struct Mlfq *q, int slot) {
+    struct PCB *pcb = &q->table[slot];
+    if (pcb->queue == SQ_READY) {
+        int level = pcb->level;
+        list_unlink(q->table, &q->head[level], &q->tail[level], slot);
+        if (q->head[level] < 0) q->ready_bitmap &= ~(1u << level);
+    } else if (pcb->queue == SQ_BLOCKED) {
+        list_unlink(q->table, &q->blocked_head, &q->blocked_tail, slot);
+        q->blocked_count--;
+    }
+    pcb->queue = SQ_NONE;
+}
+
+void mlfq_maybe_boost(struct Mlfq *q, long long now_ns) {
+    if (now_ns - q->last_boost_ns < MLFQ_BOOST_NS) return;
+    q->last_boost_ns = now_ns;
+    q->stats.boosts++;
+    // Splice every lower level onto level 0, keeping each level's order
+    for (int l = 1; l < MLFQ_LEVELS; l++) {
+        while (q->head[l] >= 0) {
+            int slot = q->head[l];
+            list_unlink(q->table, &q->head[l], &q->tail[l], slot);
+            q->table[slot].level = 0;
+            list_push(q->table, &q->head[0], &q->tail[0], slot);
+        }
+    }
+    if (q->head[0] >= 0) q->ready_bitmap = 1u;
+    // Blocked and running workers come back at the top level too
+    for (int s = q->blocked_head; s >= 0; s = q->table[s].next) {
+        q->table[s].level = 0;
+    }
+    for (int s = 0; s < MAX_PROCESSES; s++) {
+        if (q->table[s].queue == SQ_RUNNING) q->table[s].level = 0;
+    }
+}
+
+int mlfq_has_ready(const struct Mlfq *q) {
+    return q->ready_bitmap != 0;
+}
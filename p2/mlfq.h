@@ -0,0 +1,108 @@
+// mlfq.h
+
+#ifndef MLFQ_H
+#define MLFQ_H
+
+#include "evcal.h"
+#include "pcb.h"
+
+/*
+ * Multilevel feedback queue scheduler for oss -m. Ready workers wait on
+ * one FIFO per level; a bit per level in ready_bitmap says which queues
+ * are non-empty, so picking the next worker is a count-trailing-zeros
+ * and an unlink, whatever the number of workers. A worker that uses its
+ * whole quantum drops a level (quantum doubles per level); one that
+ * blocks keeps its level and sits on the blocked list until its wakeup
+ * fires from the event calendar. Every MLFQ_BOOST_NS of sim time all
+ * workers go back to level 0 so long jobs cannot starve.
+ *
+ * Queues are intrusive lists through the PCBs (pcb.h), so no memory is
+ * allocated per dispatch.
+ */
+
+#define MLFQ_LEVELS          4
+#define MLFQ_BASE_QUANTUM_NS 10000000LL    // 10 ms at level 0
+#define MLFQ_BOOST_NS        1000000000LL  // priority boost period (sim)
+#define DISPATCH_OVERHEAD_NS 1000LL        // sim time charged per dispatch on top of what the worker used
+
+// Set by oss -m; workers then wait for dispatches instead of free-running
+#define SCHED_ENV "OSS_SCHED"
+
+// Which list a PCB is on
+enum SchedQueue {
+  SQ_NONE = 0,  // not scheduled (free slot, exiting)
+  SQ_READY,     // ready[level]
+  SQ_RUNNING,   // dispatched, waiting for its reply
+  SQ_BLOCKED    // blocked list, wakeup on the calendar
+};
+
+struct SchedStats {
+  unsigned long long dispatches;
+  unsigned long long level_dispatches[MLFQ_LEVELS];
+  unsigned long long preemptions;  // used the whole quantum
+  unsigned long long blocks;       // blocked before the quantum ran out
+  unsigned long long exits;        // finished inside a quantum
+  unsigned long long boosts;
+  long long busy_ns;               // sim time charged to workers
+  long long idle_ns;               // sim time skipped with nothing ready
+};
+
+struct Mlfq {
+  struct PCB *table;  // the process table the lists run through
+  unsigned int ready_bitmap;
+  int head[MLFQ_LEVELS];
+  int tail[MLFQ_LEVELS];
+  int blocked_head;
+  int blocked_tail;
+  int blocked_count;
+  long long last_boost_ns;
+  struct EventCalendar calendar;
+  void ( *on_event )( const struct CalendarEvent *ev );  // due events other than wakeups, or NULL
+  struct SchedStats stats;
+};
+
+void mlfq_init( struct Mlfq *q, struct PCB *table );
+void mlfq_free( struct Mlfq *q );
+
+// A new worker enters the top level
+void mlfq_admit( struct Mlfq *q, int slot );
+
+// Dequeue the highest-priority ready worker (marked running), or -1
+int mlfq_pick( struct Mlfq *q );
+
+// Quantum for a worker at its current level
+long long mlfq_quantum( const struct Mlfq *q, int slot );
+
+// The running worker used its whole quantum: demote and requeue
+void mlfq_preempted( struct Mlfq *q, int slot );
+
+// The running worker blocked until wake_ns (sim)
+void mlfq_block( struct Mlfq *q, int slot, long long wake_ns );
+
+// The running worker blocked on something with no known end (oss -R: a
+// resource); it stays blocked until mlfq_unblock()
+void mlfq_wait( struct Mlfq *q, int slot );
+
+// Make a waiting worker ready again, at its level
+void mlfq_unblock( struct Mlfq *q, int slot );
+
+// The running worker gave the CPU back early but can go on: requeue at its level
+void mlfq_requeue( struct Mlfq *q, int slot );
+
+// Move blocked workers whose wakeup is due to the ready queues; returns how
+// many. Other due events go to on_event (oss -I: I/O completions).
+int mlfq_wake_due( struct Mlfq *q, long long now_ns );
+
+// Sim time of the next pending wakeup, or -1 if none
+long long mlfq_next_wakeup( const struct Mlfq *q );
+
+// Take a slot off whatever list it is on (worker exited or was reaped)
+void mlfq_remove( struct Mlfq *q, int slot );
+
+// Periodic boost: everyone back to level 0 once MLFQ_BOOST_NS has passed
+void mlfq_maybe_boost( struct Mlfq *q, long long now_ns );
+
+// 1 if any worker is ready
+int mlfq_has_ready( const struct Mlfq *q );
+
+#endif /* MLFQ_H */
@@ -34,16 +34,45 @@
  *    - Arguments:
  *      - -h: help
  *      - -n proc: number of worker processes to launch
- *      - -s simul: concurrency limit (maximum processes running simultaneously)
+ *      - -s simul: concurrency limit (maximum processes running simultaneously), or "auto" to let
+ *            oss adjust it to what the machine sustains
  *      - -t timelimit: how many simulated seconds a child can live
  *      - -i intervalInMs: how many simulated ms between spawns
+ *      - -p policy: optional CPU placement (none, compact, scatter, node)
+ *      - -T file: write a binary trace instead of text (render with tracedump)
+ *      - -o file: give every worker its own stdout pipe and merge them into file
+ *      - -d keyframe: print only table changes, with a full table every keyframe prints
+ *      - -j file: export worker lifetimes and clock counters as Chrome trace JSON
+ *      - -e: count cycles, instructions, cache misses and context switches (perf_event_open)
+ *            over the oss main loop and every worker's poll loop
+ *      - -m: schedule workers with a multilevel feedback queue instead of letting them free-run
+ *      - -M: fork and reap on helper threads so the loop only keeps the clock and the table
+ *      - -K dispatchers: like -m, but K dispatcher threads schedule shards of the table and steal work
+ *      - -R classes: like -m, and workers also request and release instances of that many resource
+ *            classes; oss grants or queues them and breaks deadlocks
+ *      - -P policy: like -m, and workers also reference memory through per-process page tables;
+ *            faults evict frames by fifo, clock or lru and wait for the paging device
+ *      - -I devices[:policy]: like -m, and workers block on I/O to that many simulated devices
+ *            (fifo or elevator queues) until the completion event fires
+ *      - -W spin:backoff:park_us: how free-running workers wait between clock reads (spin polls,
+ *            most pauses between polls, sim us left above which they park on the clock)
+ *      - -C node|llc|count[:granularity_us]: copy the clock into one line per NUMA node, per
+ *            last-level cache or per count CPUs (round-robin) at most every granularity sim us;
+ *            free-running workers read the copy for the CPU they run on
+ *      - -V rate: run sim time at rate x real time and publish only that (a clock page); free-running
+ *            workers compute the time from their own monotonic clock instead of reading oss's
+ *      - -L threads: run workers as tasks on that many threads inside oss instead of forking them, so -s
+ *            can go to 100k and more; they print the same lines with pids from TASK_PID_BASE
  *    - Uses a busy loop to increment the simulated clock, printing status every 0.5s, respecting concurrency,
  *      and checking for child termination non-blockingly.
  *    - Kills all children and cleans up if 60 real seconds pass.
  *
  * 5. Termination:
- *    - After 60 real seconds, send a signal to terminate all running child processes.
+ *    - After 60 real seconds, tell all running children to terminate through their
+ *      command channels (doorbell.h) and reap them; stragglers get SIGKILL.
  *    - Handle `SIGINT` (Ctrl-C) to clean up shared memory and terminate children.
+ *    - SIGUSR2 asks every running worker to print a status report.
+ *    - SIGUSR1 prints the latency histograms collected so far (they are also printed at exit).
  *
  * Notes:
  * - No `sleep()` or `usleep()` used for time delays.
@@ -52,18 +81,37 @@
  */
 
 #include <errno.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "autoscale.h"
 #include "clock.h"
+#include "dispatch.h"
+#include "doorbell.h"
+#include "hist.h"
+#include "iodev.h"
+#include "logger.h"
+#include "mlfq.h"
+#include "pager.h"
+#include "pcb.h"
+#include "perfctr.h"
+#include "placement.h"
+#include "procthreads.h"
+#include "resmgr.h"
+#include "segment.h"
 #include "shared.h"
-
-#define MAX_PROCESSES 20
+#include "stageprof.h"
+#include "taskpool.h"
+#include "timeline.h"
+#include "trace.h"
+#include "workerlog.h"
 
 // We'll stop after 60 real seconds
 #define REAL_TIME_LIMIT_SEC 60
@@ -101,26 +149,110 @@
  */
 #define SPIN_COUNT 5000
 
-// PCB struct for each worker
-struct PCB {
-    int occupied;  // 1 = in use, 0 = free
-    pid_t pid;     // child's PID
-    int startSec;  // time (seconds) in the simulation when forked
-    int startNano; // time (nanoseconds) in the simulation when forked
-};
+// How long workers get to act on CMD_TERMINATE before they are SIGKILLed
+#define SHUTDOWN_GRACE_NS 500000000LL
+
+// -m: how long (real) one loop pass waits for the running worker's reply
+// (the dispatch overhead charged to the clock is in mlfq.h)
+#define REPLY_WAIT_NS 1000000LL
+
+// -R: instances of each resource class, and how often (sim) to look for deadlock
+#define RES_INSTANCES 10
+#define RES_DETECT_NS 1000000000LL
+
+// -P: address space per worker (32 pages of 1 KB), physical frames, what a
+// hit costs (sim), and the lru aging tick (sim)
+#define PAGE_COUNT  32
+#define PAGE_SHIFT  10
+#define PAGE_FRAMES 256
+#define PAGE_HIT_NS 100LL
+#define PAGE_AGE_NS 100000000LL
 
 static struct PCB processTable[MAX_PROCESSES];
 
-// We'll store the SysClock pointer after attaching shared memory
+// Worker counters folded in from reaped workers (live ones are summed on demand)
+struct CounterTotals {
+    int workers;
+    unsigned long long clock_reads;
+    unsigned long long loop_iterations;
+    int overshoots;
+    long long overshoot_sum_ns;
+    long long overshoot_max_ns;
+    int startups;
+    long long startup_sum_ns;
+    long long startup_max_ns;
+};
+
+static struct CounterTotals reaped_totals;
+
+// Spawn, reap and overshoot latencies, recorded as workers are reaped
+static struct LatencyHist latency[LAT_KIND_COUNT];
+
+// CPU time, memory and context switches of reaped workers (wait4)
+static struct LatencyHist usage_hist[USAGE_KIND_COUNT];
+static long long usage_total[USAGE_KIND_COUNT];
+
+// -e: counters on the oss loop, and the sum of what reaped workers reported
+static struct PerfCounters oss_perf;
+static int oss_perf_open = 0;
+static struct PerfSample worker_perf_total;
+static int worker_perf_count = 0;
+
+// -m: the scheduler, the dispatched worker and the last reply seen per slot
+static struct Mlfq mlfq;
+static int running_slot = -1;
+static unsigned int reply_seen[MAX_PROCESSES];
+
+// -R: the resource manager and when deadlock detection last ran
+static struct ResourceManager resources;
+static long long last_detect_ns = 0;
+
+// -P: page tables and frames, and when lru last aged them
+static struct Pager pager;
+static long long last_age_ns = 0;
+
+// -I: the I/O devices
+static struct IoDevice io_devices[IO_MAX_DEVICES];
+
+// The shared segment (header + SysClock) and the clock inside it
+static struct SharedSegment *segment = NULL;
 static struct SysClock *sys_clock = NULL;
 // We'll store the shared memory ID
 static int shmid = -1;
 
 // Command line args
 static int num_workers = 0;  // -n
-static int simul       = 0;  // -s
+static int simul       = 0;  // -s (under -s auto, the current ceiling)
+static int simul_auto  = 0;  // -s auto
 static int timelimit   = 0;  // -t
 static int interval_ms = 0;  // -i
+static int placement   = PLACE_NONE; // -p
+static const char *trace_path = NULL; // -T
+static const char *worker_log_path = NULL; // -o
+static int keyframe_every = 0;             // -d (0 = always print the full table)
+static const char *timeline_path = NULL;   // -j
+static int perf_enabled = 0;               // -e
+static int sched_mode = 0;                 // -m
+static int threaded_mode = 0;              // -M
+static int dispatcher_count = 0;           // -K (0 = the loop schedules by itself)
+static int resource_classes = 0;           // -R (0 = no resource manager)
+static int paging_policy = -1;             // -P (-1 = no paging)
+static int io_device_count = 0;            // -I (0 = no I/O devices)
+static int io_policy = IO_FIFO;            // -I devices:policy
+static int poll_spin = -1;                 // -W spin (-1 = the workers' defaults)
+static int poll_backoff = 0;               // -W backoff
+static long long poll_park_us = 0;         // -W park_us
+static int clock_domain = -1;              // -C node|llc (enum PlacementDomain, -1 = not by topology)
+static int clock_replica_count = 0;        // -C count (0 = one clock line for everyone)
+static long long clock_granularity_us = 0; // -C :granularity_us
+static long long published_ns = 0;         // -C: sim time of the last replica copy
+static unsigned int published_wake_seq = 0; // -C: clock.wake_seq at the last replica copy
+static double clock_rate = 0.0;            // -V (0 = readers load the clock oss ticks)
+static int task_threads = 0;               // -L (0 = every worker is a process)
+
+// Table as of the last print, for delta snapshots
+static struct PCB lastSnapshot[MAX_PROCESSES];
+static int snapshots_since_keyframe = 0;
 
 // How many total workers have been launched
 static int launched_count = 0;
@@ -135,33 +267,129 @@ static int iteration_count = 0; // loop iteration count
 // For measuring how sim time compares to real time
 static struct timespec feedback_real_start;
 static long long feedback_sim_start_ns = 0; // baseline sim time for feedback
+static double last_ratio = 0.0;             // sim/real ratio at the last feedback check
+
+// -s auto: the controller that moves 'simul'
+static struct Autoscale autoscale;
+
+// Real time of the previous clock advance, for the tick-gap histogram
+static long long last_tick_real_ns = 0;
+
+// -M: exits the reaper reported before the spawner's result for that pid
+static struct ReapEvent unmatched_reaps[MAX_PROCESSES];
+static int unmatched_count = 0;
+
+// -K: reaped workers whose slot a dispatcher still holds
+static int retiring[MAX_PROCESSES];
+
+// Set from the SIGUSR2 handler, acted on in the main loop
+static volatile sig_atomic_t report_requested = 0;
+static volatile sig_atomic_t histograms_requested = 0;
 
 // Prototypes
 static void parse_args(int argc, char *argv[]);
+static int reserve_slot(void);
+static pid_t launch_worker(int slot, int *cpu);
+static void commit_spawn(int slot, pid_t pid, int cpu);
 static void spawn_one_worker(void);
+static void request_spawn(void);
 static void handle_nonblocking_wait(void);
+static int reap_pid(pid_t pid, int status, const struct rusage *ru);
+static void collect_thread_events(void);
+static void free_retired_slots(void);
+static void sync_dispatch_states(void);
 static void print_process_table(void);
+static void print_table_delta(long long sim_ns);
+static void accumulate_counters(struct CounterTotals *totals, const struct WorkerCounters *ctr);
+static void record_usage(struct PCB *pcb, int status, const struct rusage *ru);
+static void reap_slot(int slot, int status, const struct rusage *ru);
+static void emit_counter_totals(int type, int include_live);
+static void emit_latency_histograms(void);
+static void emit_usage_summary(void);
+static void emit_perf_counters(void);
+static void schedule_step(long long next_spawn_ns);
+static void finish_dispatch(int slot);
+static void emit_sched_stats(void);
+static void grant_waiting_workers(void);
+static void resolve_deadlocks(long long now_ns);
+static void emit_resource_stats(void);
+static void emit_paging_stats(void);
+static void io_completed(const struct CalendarEvent *ev);
+static void emit_io_stats(void);
+static void autoscale_tick(long long real_ns);
+static void emit_autoscale_summary(void);
 static void kill_all_children(void);
+static int active_workers(void);
+static void on_task_event(const struct TaskEvent *ev);
+static void occupied_slots(int *occupied);
+static void publish_slot(int slot);
+static void publish_status(void);
+static void on_report_signal(int signum);
 static void cleanup_and_exit(void);
 
 int main(int argc, char *argv[]) {
     parse_args(argc, argv);
+    if (simul_auto) {
+        autoscale_init(&autoscale, MAX_PROCESSES);
+        simul = autoscale.ceiling;
+    }
+
+    // -M: only the reaper thread may take SIGCHLD; block it before the
+    // logger and log-merger threads exist so every thread inherits the mask
+    if (threaded_mode) {
+        procthreads_block_sigchld();
+    }
 
     // Clear out the process table
     memset(processTable, 0, sizeof(processTable));
 
-    // 1) Initialize semaphore / shared memory system
+    // Binary trace: workers inherit the path through the environment
+    if (trace_path && trace_create(trace_path) == -1) {
+        exit(1);
+    }
+
+    // Worker stdout pipes are merged into one log by a splice() thread
+    if (worker_log_path && worker_log_start(worker_log_path) == -1) {
+        exit(1);
+    }
+
+    // 0) Pin ourselves before touching the segment so it lands on our node
+    placement_init(placement);
+
+    // 1) Create the segment, or reclaim it in place if a previous oss died
+    //    without cleaning up (this also drops a leaked semaphore)
+    segment = claim_shared_segment(&shmid);
+    sys_clock = &segment->clock;
+    placement_bind_memory(segment, sizeof(*segment));
+
+    // 2) Initialize semaphore / shared memory system
     init_shared_memory_system();
 
-    // 2) Create & attach the SysClock
-    shmid = create_shared_memory(SHM_KEY, sizeof(struct SysClock));
-    sys_clock = (struct SysClock *)attach_shared_memory_rw(shmid);
-    if (!sys_clock) {
-        handle_error("Failed to attach shared memory (RW)");
+    // 3) The clock was zeroed when the segment was claimed; osstop can
+    //    already see the configuration
+    publish_status();
+
+    // SIGUSR2 => broadcast CMD_REPORT
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_report_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGUSR2, &sa, NULL) == -1) {
+        perror("sigaction SIGUSR2");
+    }
+    // SIGUSR1 => print the latency histograms
+    if (sigaction(SIGUSR1, &sa, NULL) == -1) {
+        perror("sigaction SIGUSR1");
     }
 
-    // 3) Initialize the clock to zero
-    initialize_clock(sys_clock);
+    // Text output is formatted and written by a logger thread so the loop
+    // below never blocks on stdout (with -T nothing is formatted at all)
+    if (!trace_enabled()) {
+        logger_start();
+        // -L: the lines are all there is of a task, so wait rather than drop them
+        if (task_threads > 0) logger_set_lossless(1);
+    }
 
     // 4) Capture real start time for the 60s cutoff
     if (clock_gettime(CLOCK_MONOTONIC, &real_start) == -1) {
@@ -169,16 +397,128 @@ int main(int argc, char *argv[]) {
         cleanup_and_exit();
     }
 
+    // Timeline timestamps are relative to this moment
+    if (timeline_path &&
+        timeline_open(timeline_path, (long long)real_start.tv_sec * 1000000000LL + real_start.tv_nsec) == -1) {
+        cleanup_and_exit();
+    }
+
     // Initialize feedback baseline
     feedback_real_start = real_start;
     feedback_sim_start_ns = 0; // we just zeroed the clock
 
+    // -V: sim time starts now at the requested rate; the page is written
+    // again only if the rate changes
+    if (clock_rate > 0.0) {
+        clock_page_set_rate(&segment->clock_page, 0, (long long)real_start.tv_sec * 1000000000LL + real_start.tv_nsec,
+                            clock_rate);
+        __atomic_store_n(&segment->clock_page.active, 1, __ATOMIC_RELEASE);
+        logger_printf("OSS: clock page at %.3f sim s per real s\n", clock_rate);
+    }
+
+    // Self-profiling covers the loop below and nothing else
+    if (perf_enabled) {
+        perf_counters_request();
+        perf_sample_clear(&worker_perf_total);
+        oss_perf_open = perf_counters_open(&oss_perf) > 0;
+        if (!oss_perf_open) {
+            fprintf(stderr, "OSS: perf_event_open failed for every counter, oss loop not profiled\n");
+        }
+    }
+
+    // The scheduler charges the clock for dispatched work; workers learn
+    // through the environment to wait for dispatches
+    if (sched_mode) {
+        if (dispatcher_count == 0) {
+            mlfq_init(&mlfq, processTable);
+        } else if (dispatch_start(segment, dispatcher_count) == -1) {
+            cleanup_and_exit();
+        }
+        setenv(SCHED_ENV, "1", 1);
+    }
+
+    // -R: workers learn the resource layout through the environment
+    if (resource_classes > 0) {
+        if (resmgr_init(&resources, resource_classes, RES_INSTANCES, MAX_PROCESSES) == -1) {
+            fprintf(stderr, "OSS: cannot allocate the resource matrices\n");
+            cleanup_and_exit();
+        }
+        char layout[32];
+        snprintf(layout, sizeof(layout), "%d:%d", resource_classes, RES_INSTANCES);
+        setenv(RES_ENV, layout, 1);
+    }
+
+    // -P: likewise the size of their address spaces
+    if (paging_policy >= 0) {
+        if (pager_init(&pager, paging_policy, MAX_PROCESSES, PAGE_COUNT, PAGE_SHIFT, PAGE_FRAMES) == -1) {
+            fprintf(stderr, "OSS: cannot allocate the page and frame tables\n");
+            cleanup_and_exit();
+        }
+        char layout[32];
+        snprintf(layout, sizeof(layout), "%d:%d", PAGE_COUNT, PAGE_SHIFT);
+        setenv(PAGER_ENV, layout, 1);
+    }
+
+    // -W: how free-running workers poll the clock
+    if (poll_spin >= 0) {
+        char layout[64];
+        snprintf(layout, sizeof(layout), "%d:%d:%lld", poll_spin, poll_backoff, poll_park_us * 1000);
+        setenv(POLL_ENV, layout, 1);
+    }
+
+    // -C: one clock line per domain; every CPU maps to the line of its
+    // domain, and the lines get their first copy before anyone reads them
+    if (clock_domain >= 0 || clock_replica_count > 0) {
+        struct ClockReplicaSet *set = &segment->replicas;
+        int domain_of[CLOCK_REPLICA_CPUS];
+        int count = clock_replica_count;
+        if (clock_domain >= 0) {
+            count = placement_domains(clock_domain, domain_of, CLOCK_REPLICA_CPUS, CLOCK_MAX_REPLICAS);
+        } else {
+            for (int cpu = 0; cpu < CLOCK_REPLICA_CPUS; cpu++) domain_of[cpu] = cpu % count;
+        }
+        for (int cpu = 0; cpu < CLOCK_REPLICA_CPUS; cpu++) {
+            set->of_cpu[cpu] = (unsigned char)(domain_of[cpu] >= 0 ? domain_of[cpu] : 0);
+        }
+        set->granularity_ns = clock_granularity_us * 1000;
+        clock_publish(sys_clock, set->lines, count);
+        __atomic_store_n(&set->count, count, __ATOMIC_RELEASE);
+        logger_printf("OSS: clock replicated on %d line%s (%s), copied every %lld sim us at most\n", count,
+                      count == 1 ? "" : "s",
+                      clock_domain == DOMAIN_NODE ? "node" : clock_domain == DOMAIN_LLC ? "llc" : "round-robin",
+                      clock_granularity_us);
+    }
+
+    // -I: and the devices they can do I/O to; completions arrive as
+    // calendar events
+    if (io_device_count > 0) {
+        for (int d = 0; d < io_device_count; d++) iodev_init(&io_devices[d], d, io_policy);
+        mlfq.on_event = io_completed;
+        char layout[32];
+        snprintf(layout, sizeof(layout), "%d:%d", io_device_count, IO_CYLINDERS);
+        setenv(IODEV_ENV, layout, 1);
+    }
+
+    // -L: no processes at all; the pool threads run the workers as tasks
+    if (task_threads > 0) {
+        if (taskpool_start(segment, task_threads, on_task_event) == -1) cleanup_and_exit();
+        logger_printf("OSS: workers run as tasks on %d pool thread%s\n", task_threads, task_threads == 1 ? "" : "s");
+    }
+
+    // -M: forks and waitpid() move to the spawner and reaper threads
+    if (threaded_mode && procthreads_start(launch_worker) == -1) {
+        cleanup_and_exit();
+    }
+
     long long last_print_ns = 0; // for printing table every 0.5s
     long long last_spawn_ns = 0; // track last spawn time in sim ns
 
+    if (oss_perf_open) perf_counters_enable(&oss_perf);
+
     // Main loop
     while (1) {
         // (A) Check if 60 real seconds have passed
+        STAGE_ENTER(STAGE_A_TIMECHECK);
         struct timespec now;
         if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
             perror("clock_gettime (loop)");
@@ -189,63 +529,142 @@ int main(int argc, char *argv[]) {
             (long long)(now.tv_nsec - real_start.tv_nsec);
 
         if (elapsed_real_ns >= (long long)REAL_TIME_LIMIT_SEC * 1000000000LL) {
-            printf("OSS: 60 real seconds elapsed. Stopping.\n");
+            logger_printf("OSS: 60 real seconds elapsed. Stopping.\n");
             break;
         }
 
         // (B) ***Spin*** to slow down the loop in real time
-        for (volatile int i = 0; i < SPIN_COUNT; i++) {
-            // do nothing - purely burn CPU time
+        //     (not under -m: the clock then follows dispatched work, not real time)
+        STAGE_ENTER(STAGE_B_SPIN);
+        if (!sched_mode) {
+            for (volatile int i = 0; i < SPIN_COUNT; i++) {
+                // do nothing - purely burn CPU time
+            }
         }
 
         // (C) Increment the simulated clock by current_increment
-        increment_clock(sys_clock, current_increment);
+        //     (-m: dispatch the next worker and charge what it used instead)
+        STAGE_ENTER(STAGE_C_TICK);
+        if (sched_mode) {
+            long long next_spawn_ns = launched_count < num_workers
+                                          ? last_spawn_ns + (long long)interval_ms * 1000000LL
+                                          : -1;
+            if (dispatcher_count > 0) {
+                dispatch_advance_clock(sys_clock, next_spawn_ns, current_increment, REPLY_WAIT_NS);
+            } else {
+                schedule_step(next_spawn_ns);
+            }
+        } else if (clock_rate > 0.0) {
+            // Follow the page. The clock has its own line and workers read
+            // the page instead, so the store stays in our cache; parked
+            // workers are still woken from here.
+            long long real_ns = (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+            long long page_ns = clock_page_read(&segment->clock_page, real_ns);
+            long long sim_ns  = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+            if (page_ns > sim_ns) increment_clock(sys_clock, page_ns - sim_ns);
+        } else {
+            increment_clock(sys_clock, current_increment);
+        }
+        if (segment->replicas.count > 0) {
+            struct ClockReplicaSet *set = &segment->replicas;
+            long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+            unsigned int wake_seq = __atomic_load_n(&sys_clock->wake_seq, __ATOMIC_RELAXED);
+            if (sim_ns - published_ns >= set->granularity_ns || wake_seq != published_wake_seq) {
+                clock_publish(sys_clock, set->lines, set->count);
+                published_ns       = sim_ns;
+                published_wake_seq = wake_seq;
+            }
+        }
+        long long tick_real_ns = (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+        if (last_tick_real_ns > 0) {
+            hist_record(&latency[LAT_TICK_GAP], tick_real_ns - last_tick_real_ns);
+        }
+        last_tick_real_ns = tick_real_ns;
 
         // (D) Check for finished children (non-blocking wait)
-        handle_nonblocking_wait();
+        //     (-M: apply what the spawner and reaper threads queued)
+        STAGE_ENTER(STAGE_D_WAITPID);
+        if (dispatcher_count > 0) {
+            free_retired_slots();
+        }
+        if (task_threads > 0) {
+            taskpool_collect();
+        } else if (threaded_mode) {
+            collect_thread_events();
+        } else {
+            handle_nonblocking_wait();
+        }
 
         // (E) Possibly spawn a new worker if concurrency & interval allow
+        STAGE_ENTER(STAGE_E_SPAWN);
         if (launched_count < num_workers) {
-            // Count active
-            int active_count = 0;
-            for (int i = 0; i < MAX_PROCESSES; i++) {
-                if (processTable[i].occupied) active_count++;
-            }
-            if (active_count < simul) {
+            if (active_workers() < simul) {
                 // If we've advanced enough sim time since last spawn
                 long long sim_now_ns =
                     (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
                 if (sim_now_ns >= last_spawn_ns + (long long)interval_ms * 1000000LL) {
-                    spawn_one_worker();
-                    launched_count++;
-                    last_spawn_ns = sim_now_ns;
+                    STAGE_HIT(STAGE_E_SPAWN);
+                    int spawned = 1;
+                    if (task_threads > 0) {
+                        // Same lifetime a forked worker is given (timelimit s + 0.5 s);
+                        // a full queue just retries on the next pass
+                        spawned = taskpool_spawn((long long)timelimit * 1000000000LL + 500000000LL);
+                    } else if (threaded_mode) {
+                        request_spawn();
+                    } else {
+                        spawn_one_worker();
+                    }
+                    if (spawned) {
+                        launched_count++;
+                        last_spawn_ns = sim_now_ns;
+                        publish_status();
+                    }
                 }
             }
         }
 
         // (F) Print table every 0.5 sim seconds
+        STAGE_ENTER(STAGE_F_PRINT);
         long long current_sim_ns =
             (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
         if (current_sim_ns >= last_print_ns + HALF_SECOND_NS) {
+            STAGE_HIT(STAGE_F_PRINT);
             print_process_table();
             last_print_ns = current_sim_ns;
         }
+        // -j counter tracks, in every mode (one sample per 10 ms real is kept)
+        if (timeline_enabled()) {
+            timeline_counters(current_sim_ns, (long long)now.tv_sec * 1000000000LL + now.tv_nsec, active_workers(),
+                              current_increment, last_ratio);
+        }
+        if (report_requested) {
+            int occupied[MAX_PROCESSES];
+            occupied_slots(occupied);
+            broadcast_command(segment, occupied, CMD_REPORT);
+            if (task_threads > 0) taskpool_report();
+            STAGE_SYSCALL();
+            report_requested = 0;
+        }
+        if (histograms_requested) {
+            emit_latency_histograms();
+            histograms_requested = 0;
+        }
 
         // (G) If all workers launched & none active => done
+        STAGE_ENTER(STAGE_G_DONECHECK);
         if (launched_count >= num_workers) {
-            int still_active = 0;
-            for (int i = 0; i < MAX_PROCESSES; i++) {
-                if (processTable[i].occupied) still_active++;
-            }
-            if (still_active == 0) {
-                printf("OSS: All workers finished.\n");
+            if (active_workers() == 0) {
+                logger_printf("OSS: All workers finished.\n");
                 break;
             }
         }
 
         // (H) Every FEEDBACK_CHECK_INTERVAL loops, measure ratio & adapt
+        //     (the scheduler does not track real time, so not under -m)
+        STAGE_ENTER(STAGE_H_FEEDBACK);
         iteration_count++;
-        if (iteration_count % FEEDBACK_CHECK_INTERVAL == 0) {
+        if (!sched_mode && iteration_count % FEEDBACK_CHECK_INTERVAL == 0) {
+            STAGE_HIT(STAGE_H_FEEDBACK);
             // measure real time since last feedback
             struct timespec now_fb;
             if (clock_gettime(CLOCK_MONOTONIC, &now_fb) == -1) {
@@ -266,8 +685,8 @@ int main(int argc, char *argv[]) {
                 ratio = (double)sim_passed_ns / (double)real_passed_ns;
             }
 
-            // If ratio ~ 1 => no change
-            if (ratio < DEAD_BAND_LOWER || ratio > DEAD_BAND_UPPER) {
+            // If ratio ~ 1 => no change (-V: the page sets the pace)
+            if (clock_rate <= 0.0 && (ratio < DEAD_BAND_LOWER || ratio > DEAD_BAND_UPPER)) {
                 // out of dead band => let's adapt
                 double error = ratio - 1.0;
 
@@ -296,11 +715,16 @@ int main(int argc, char *argv[]) {
                 }
             }
             // else do nothing if ratio is within the dead band
+            last_ratio = ratio;
+            publish_status();
 
             // reset feedback baseline
             feedback_real_start = now_fb;
             feedback_sim_start_ns = sim_now_ns2;
         }
+        if (simul_auto) {
+            autoscale_tick(tick_real_ns);
+        }
 
         // busy loop => no other real sleeps
     }
@@ -313,114 +737,1083 @@ int main(int argc, char *argv[]) {
 // ------------------------------------------------------------------------
 static void parse_args(int argc, char *argv[]) {
     if (argc < 9) {
-        fprintf(stderr, "Usage: %s -n <num_workers> -s <simul> -t <timelimit> -i <interval_ms>\n", argv[0]);
+        fprintf(stderr,
+                "Usage: %s -n <num_workers> -s <simul|auto> -t <timelimit> -i <interval_ms> [-p <placement>] "
+                "[-T <trace_file>] [-o <worker_log>] [-d <keyframe_every>] [-j <timeline.json>] [-e] [-m] [-M] "
+                "[-K <dispatchers>] [-R <classes>] [-P <fifo|clock|lru>] "
+                "[-I <devices>[:fifo|elevator]] [-W <spin>:<backoff>:<park_us>] "
+                "[-C <node|llc|count>[:granularity_us]] [-V <rate>] [-L <threads>]\n",
+                argv[0]);
         exit(1);
     }
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-n") == 0) {
             num_workers = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-s") == 0) {
-            simul = atoi(argv[++i]);
+            if (strcmp(argv[++i], "auto") == 0) {
+                simul_auto = 1;
+            } else {
+                simul = atoi(argv[i]);
+            }
         } else if (strcmp(argv[i], "-t") == 0) {
             timelimit = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-i") == 0) {
             interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            placement = parse_placement_policy(argv[++i]);
+            if (placement < 0) {
+                fprintf(stderr, "Unknown placement '%s' (none, compact, scatter, node)\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-T") == 0) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0) {
+            worker_log_path = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0) {
+            keyframe_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0) {
+            timeline_path = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0) {
+            perf_enabled = 1;
+        } else if (strcmp(argv[i], "-m") == 0) {
+            sched_mode = 1;
+        } else if (strcmp(argv[i], "-M") == 0) {
+            threaded_mode = 1;
+        } else if (strcmp(argv[i], "-K") == 0) {
+            dispatcher_count = atoi(argv[++i]);
+            if (dispatcher_count < 1 || dispatcher_count > MAX_PROCESSES) {
+                fprintf(stderr, "-K wants 1 to %d dispatchers\n", MAX_PROCESSES);
+                exit(1);
+            }
+            sched_mode = 1;
+        } else if (strcmp(argv[i], "-R") == 0) {
+            resource_classes = atoi(argv[++i]);
+            if (resource_classes < 1 || resource_classes > RES_MAX_CLASSES) {
+                fprintf(stderr, "-R wants 1 to %d resource classes\n", RES_MAX_CLASSES);
+                exit(1);
+            }
+            sched_mode = 1;
+        } else if (strcmp(argv[i], "-P") == 0) {
+            paging_policy = page_policy_parse(argv[++i]);
+            if (paging_policy < 0) {
+                fprintf(stderr, "Unknown paging policy '%s' (fifo, clock, lru)\n", argv[i]);
+                exit(1);
+            }
+            sched_mode = 1;
+        } else if (strcmp(argv[i], "-I") == 0) {
+            const char *spec = argv[++i];
+            const char *colon = strchr(spec, ':');
+            io_device_count = atoi(spec);
+            if (io_device_count < 1 || io_device_count > IO_MAX_DEVICES) {
+                fprintf(stderr, "-I wants 1 to %d devices\n", IO_MAX_DEVICES);
+                exit(1);
+            }
+            if (colon && (io_policy = io_policy_parse(colon + 1)) < 0) {
+                fprintf(stderr, "Unknown I/O queue policy '%s' (fifo, elevator)\n", colon + 1);
+                exit(1);
+            }
+            sched_mode = 1;
+        } else if (strcmp(argv[i], "-W") == 0) {
+            if (sscanf(argv[++i], "%d:%d:%lld", &poll_spin, &poll_backoff, &poll_park_us) != 3 || poll_spin < 0 ||
+                poll_backoff < 0 || poll_park_us < 0) {
+                fprintf(stderr, "-W wants <spin>:<backoff>:<park_us>, each 0 or more\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-C") == 0) {
+            char *spec  = argv[++i];
+            char *colon = strchr(spec, ':');
+            if (colon) {
+                *colon = '\0';
+                clock_granularity_us = atoll(colon + 1);
+            }
+            if (strcmp(spec, "node") == 0) {
+                clock_domain = DOMAIN_NODE;
+            } else if (strcmp(spec, "llc") == 0) {
+                clock_domain = DOMAIN_LLC;
+            } else {
+                clock_replica_count = atoi(spec);
+            }
+            if ((clock_domain < 0 && (clock_replica_count < 1 || clock_replica_count > CLOCK_MAX_REPLICAS)) ||
+                clock_granularity_us < 0) {
+                fprintf(stderr, "-C wants node, llc or 1 to %d replicas, and a granularity of 0 us or more\n",
+                        CLOCK_MAX_REPLICAS);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-V") == 0) {
+            clock_rate = strtod(argv[++i], NULL);
+            if (clock_rate <= 0.0) {
+                fprintf(stderr, "-V wants a rate above 0 (sim seconds per real second)\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-L") == 0) {
+            task_threads = atoi(argv[++i]);
+            if (task_threads < 1 || task_threads > TASKPOOL_MAX_THREADS) {
+                fprintf(stderr, "-L wants 1 to %d pool threads\n", TASKPOOL_MAX_THREADS);
+                exit(1);
+            }
         } else if (strcmp(argv[i], "-h") == 0) {
-            printf("Usage: %s -n <num_workers> -s <simul> -t <timelimit> -i <interval_ms>\n", argv[0]);
+            printf("Usage: %s -n <num_workers> -s <simul|auto> -t <timelimit> -i <interval_ms> [-p <placement>] "
+                   "[-T <trace_file>] [-o <worker_log>] [-d <keyframe_every>] [-j <timeline.json>] [-e] [-m] [-M] "
+                   "[-K <dispatchers>] [-R <classes>] [-P <fifo|clock|lru>] "
+                   "[-I <devices>[:fifo|elevator]] [-W <spin>:<backoff>:<park_us>] "
+                   "[-C <node|llc|count>[:granularity_us]] [-V <rate>] [-L <threads>]\n",
+                   argv[0]);
             exit(0);
         }
     }
+    // Grants and deadlock victims are decided by the loop's own scheduler
+    if (resource_classes > 0 && dispatcher_count > 0) {
+        fprintf(stderr, "-R cannot be combined with -K\n");
+        exit(1);
+    }
+    if (paging_policy >= 0 && dispatcher_count > 0) {
+        fprintf(stderr, "-P cannot be combined with -K\n");
+        exit(1);
+    }
+    if (io_device_count > 0 && dispatcher_count > 0) {
+        fprintf(stderr, "-I cannot be combined with -K\n");
+        exit(1);
+    }
+    // Scheduled time follows dispatched work, not real time
+    if (clock_rate > 0.0 && sched_mode) {
+        fprintf(stderr, "-V cannot be combined with -m, -K, -R, -P or -I\n");
+        exit(1);
+    }
+    if (clock_rate > 0.0 && (clock_domain >= 0 || clock_replica_count > 0)) {
+        fprintf(stderr, "-V cannot be combined with -C\n");
+        exit(1);
+    }
+    // Tasks free-run and have no process, pipe or PCB of their own
+    if (task_threads > 0 && (sched_mode || threaded_mode || worker_log_path || simul_auto)) {
+        fprintf(stderr, "-L cannot be combined with -m, -K, -R, -P, -I, -M, -o or -s auto\n");
+        exit(1);
+    }
 }
 
 // ------------------------------------------------------------------------
-static void spawn_one_worker(void) {
-    // find a free PCB
+// Claim a free PCB for a new worker and reset its segment lines; -1 if full
+static int reserve_slot(void) {
     for (int i = 0; i < MAX_PROCESSES; i++) {
         if (!processTable[i].occupied) {
-            processTable[i].occupied = 1;
-            processTable[i].startSec  = sys_clock->sec;
-            processTable[i].startNano = sys_clock->nano;
-
-            pid_t cpid = fork();
-            if (cpid < 0) {
-                perror("fork");
-                processTable[i].occupied = 0;
-                return;
-            }
-            if (cpid == 0) {
-                // Child
-                // We'll pass timelimit as <sec> plus 500000000 ns
-                char sec_str[32], ns_str[32];
-                snprintf(sec_str, sizeof(sec_str), "%d", timelimit);
-                snprintf(ns_str, sizeof(ns_str), "%d", 500000000);
-
-                execlp("./worker", "worker", sec_str, ns_str, (char *)NULL);
-                perror("execlp worker");
-                exit(1);
-            }
-            // parent
-            processTable[i].pid = cpid;
-            return;
+            processTable[i].occupied    = 1;
+            processTable[i].state       = PCB_SPAWNING;
+            processTable[i].pid         = 0;
+            processTable[i].startSec    = sys_clock->sec;
+            processTable[i].startNano   = sys_clock->nano;
+            processTable[i].cpu         = placement_cpu_for_slot(i);
+            processTable[i].exit_status = 0;
+            memset(&processTable[i].usage, 0, sizeof(processTable[i].usage));
+
+            memset(&segment->counters[i], 0, sizeof(segment->counters[i]));
+            reset_channel(segment, i);
+            perf_sample_clear(&segment->perf[i]);
+            publish_slot(i);
+            return i;
         }
     }
     fprintf(stderr, "OSS: No free slot in processTable.\n");
+    return -1;
+}
+
+// Fork and exec the worker for a reserved slot, pinned to *cpu (reset to
+// -1 if pinning fails). Touches nothing in processTable, so under -M it
+// runs on the spawner thread.
+static pid_t launch_worker(int slot, int *cpu) {
+    segment->counters[slot].spawn_real_ns = monotonic_ns();
+
+    // With -o the worker's stdout is a pipe only oss reads
+    int out_pipe[2] = { -1, -1 };
+    if (worker_log_enabled() && worker_log_pipe(out_pipe) == -1) {
+        return -1;
+    }
+
+    pid_t cpid = fork();
+    STAGE_SYSCALL();
+    if (cpid < 0) {
+        perror("fork");
+        if (out_pipe[0] != -1) {
+            close(out_pipe[0]);
+            close(out_pipe[1]);
+        }
+        return -1;
+    }
+    if (cpid == 0) {
+        if (threaded_mode) {
+            procthreads_unblock_sigchld();
+        }
+        if (out_pipe[1] != -1 && dup2(out_pipe[1], STDOUT_FILENO) == -1) {
+            perror("dup2 worker stdout");
+            exit(1);
+        }
+        // Child
+        // We'll pass timelimit as <sec> plus 500000000 ns
+        // plus the PCB slot so it can find its counter block
+        char sec_str[32], ns_str[32], slot_str[32];
+        snprintf(sec_str, sizeof(sec_str), "%d", timelimit);
+        snprintf(ns_str, sizeof(ns_str), "%d", 500000000);
+        snprintf(slot_str, sizeof(slot_str), "%d", slot);
+
+        execlp("./worker", "worker", sec_str, ns_str, slot_str, (char *)NULL);
+        perror("execlp worker");
+        exit(1);
+    }
+    // parent
+    if (out_pipe[0] != -1) {
+        close(out_pipe[1]);
+        worker_log_attach(out_pipe[0], slot, cpid);
+    }
+    if (out_pipe[0] != -1) STAGE_SYSCALL();  // pipe2
+    if (*cpu >= 0) STAGE_SYSCALL();  // sched_setaffinity
+    if (placement_pin(cpid, *cpu) == -1) {
+        perror("sched_setaffinity worker");
+        *cpu = -1;
+    }
+    return cpid;
+}
+
+// Record the outcome of launch_worker() for a reserved slot
+static void commit_spawn(int slot, pid_t pid, int cpu) {
+    if (pid < 0) {
+        processTable[slot].occupied = 0;
+        processTable[slot].state    = PCB_EMPTY;
+        publish_slot(slot);
+        publish_status();
+        return;
+    }
+    processTable[slot].pid   = pid;
+    processTable[slot].state = PCB_RUNNING;
+    processTable[slot].cpu   = cpu;
+    if (dispatcher_count > 0) {
+        dispatch_admit(slot);
+    } else if (sched_mode) {
+        reply_seen[slot] = 0;
+        mlfq_admit(&mlfq, slot);
+    }
+    publish_slot(slot);
+}
+
+static void spawn_one_worker(void) {
+    int slot = reserve_slot();
+    if (slot < 0) return;
+    int cpu = processTable[slot].cpu;
+    pid_t pid = launch_worker(slot, &cpu);
+    commit_spawn(slot, pid, cpu);
+}
+
+// -M: reserve the slot here and let the spawner thread fork
+static void request_spawn(void) {
+    int slot = reserve_slot();
+    if (slot < 0) return;
+    if (!procthreads_request_spawn(slot, processTable[slot].cpu)) {
+        commit_spawn(slot, -1, -1);
+    }
 }
 
-// ------------------------------------------------------------------------
 static void handle_nonblocking_wait(void) {
     int status;
+    struct rusage ru;
     pid_t cpid;
-    while ((cpid = waitpid(-1, &status, WNOHANG)) > 0) {
-        // Mark that PCB slot free
-        for (int i = 0; i < MAX_PROCESSES; i++) {
-            if (processTable[i].occupied && processTable[i].pid == cpid) {
-                processTable[i].occupied = 0;
-                break;
-            }
+    for (;;) {
+        STAGE_SYSCALL();
+        cpid = wait4(-1, &status, WNOHANG, &ru);
+        if (cpid <= 0) break;
+        STAGE_HIT(STAGE_D_WAITPID);
+        reap_pid(cpid, status, &ru);
+    }
+}
+
+// Fold an exited child's counters in and free its PCB; 0 if no slot has it
+static int reap_pid(pid_t pid, int status, const struct rusage *ru) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processTable[i].occupied && processTable[i].state != PCB_SPAWNING && !retiring[i] &&
+            processTable[i].pid == pid) {
+            reap_slot(i, status, ru);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// -K: free the slots of reaped workers that their dispatcher has let go of
+static void free_retired_slots(void) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (retiring[i] && dispatch_retired(i)) {
+            retiring[i]              = 0;
+            processTable[i].occupied = 0;
+            processTable[i].state    = PCB_EMPTY;
+            publish_slot(i);
+            publish_status();
+        }
+    }
+}
+
+// -K: the dispatchers own the scheduling state; copy it in before printing
+static void sync_dispatch_states(void) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        struct PCB *pcb = &processTable[i];
+        if (!pcb->occupied || retiring[i] || pcb->state == PCB_SPAWNING) continue;
+        int state = dispatch_slot_state(i);
+        if (state != pcb->state) {
+            pcb->state = state;
+            publish_slot(i);
+        }
+    }
+}
+
+// -M: apply what the helper threads queued since the last pass. Launches
+// go first so an exit normally finds its pid; one that raced ahead of
+// its launch result waits in unmatched_reaps for the next pass.
+static void collect_thread_events(void) {
+    struct SpawnResult res;
+    while (procthreads_next_spawned(&res)) {
+        commit_spawn(res.slot, res.pid, res.cpu);
+    }
+
+    int still_unmatched = 0;
+    for (int k = 0; k < unmatched_count; k++) {
+        const struct ReapEvent *ev = &unmatched_reaps[k];
+        if (!reap_pid(ev->pid, ev->status, &ev->usage)) unmatched_reaps[still_unmatched++] = *ev;
+    }
+    unmatched_count = still_unmatched;
+
+    struct ReapEvent ev;
+    while (procthreads_next_reaped(&ev)) {
+        STAGE_HIT(STAGE_D_WAITPID);
+        if (!reap_pid(ev.pid, ev.status, &ev.usage) && unmatched_count < MAX_PROCESSES) {
+            unmatched_reaps[unmatched_count++] = ev;
         }
     }
 }
 
 // ------------------------------------------------------------------------
 static void print_process_table(void) {
-    printf("\nOSS: SysClock %d s, %d ns, incr=%lld\n",
-           sys_clock->sec, sys_clock->nano, current_increment);
-    printf("Process Table (PID / startSec / startNano):\n");
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    if (dispatcher_count > 0) sync_dispatch_states();
+
+    // Delta mode: only changes, except for a full keyframe every N prints
+    if (keyframe_every > 0) {
+        if (snapshots_since_keyframe > 0 && snapshots_since_keyframe < keyframe_every) {
+            print_table_delta(sim_ns);
+            snapshots_since_keyframe++;
+            return;
+        }
+        snapshots_since_keyframe = 1;
+        memcpy(lastSnapshot, processTable, sizeof(lastSnapshot));
+    }
+
+    const long long begin[] = { current_increment };
+    trace_event(TRACE_TABLE_BEGIN, -1, sim_ns, begin, 1);
+    if (placement != PLACE_NONE) {
+        int oss_cpu = placement_oss_cpu();
+        const long long where[] = { placement, oss_cpu, placement_node_of(oss_cpu) };
+        trace_event(TRACE_TABLE_PLACEMENT, -1, sim_ns, where, 3);
+    }
+    trace_event(TRACE_TABLE_HEADER, -1, sim_ns, NULL, 0);
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (!processTable[i].occupied) continue;
+        const long long row[] = {
+            processTable[i].pid,
+            processTable[i].startSec,
+            processTable[i].startNano,
+            processTable[i].cpu,
+            placement_node_of(processTable[i].cpu),
+        };
+        trace_event(TRACE_TABLE_ROW, i, sim_ns, row, placement != PLACE_NONE ? 5 : 3);
+    }
+    emit_counter_totals(TRACE_TABLE_COUNTERS, 1);
+    if (task_threads > 0) {
+        const long long tasks[] = { taskpool_active(), launched_count, launched_count - taskpool_active(),
+                                    task_threads };
+        trace_event(TRACE_TASKS, -1, sim_ns, tasks, 4);
+    }
+    trace_event(TRACE_TABLE_END, -1, sim_ns, NULL, 0);
+}
+
+// ------------------------------------------------------------------------
+// Emit what changed since the previous print: freed slots, new (or reused)
+// slots and state transitions. Cost and output scale with churn, not size.
+static void print_table_delta(long long sim_ns) {
+    int changes = 0;
     for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processTable[i].occupied) {
-            printf("  [%2d] pid=%d start=(%d, %d)\n",
-                   i,
-                   processTable[i].pid,
-                   processTable[i].startSec,
-                   processTable[i].startNano);
+        const struct PCB *was = &lastSnapshot[i];
+        const struct PCB *now = &processTable[i];
+        if (was->occupied != now->occupied || was->pid != now->pid || was->state != now->state) changes++;
+    }
+    const long long begin[] = { current_increment, changes, keyframe_every - snapshots_since_keyframe };
+    trace_event(TRACE_DELTA_BEGIN, -1, sim_ns, begin, 3);
+    if (changes == 0) return;
+
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        struct PCB *was       = &lastSnapshot[i];
+        const struct PCB *now = &processTable[i];
+        int replaced          = was->occupied && now->occupied && was->pid != now->pid && was->state != PCB_SPAWNING;
+        if (was->occupied && (!now->occupied || replaced)) {
+            const long long gone[] = { was->pid };
+            trace_event(TRACE_DELTA_REMOVE, i, sim_ns, gone, 1);
+        }
+        if (now->occupied && (!was->occupied || replaced)) {
+            const long long row[] = {
+                now->pid, now->startSec, now->startNano, now->cpu, placement_node_of(now->cpu),
+            };
+            trace_event(TRACE_DELTA_ADD, i, sim_ns, row, placement != PLACE_NONE ? 5 : 3);
+        } else if (now->occupied && was->state != now->state) {
+            const long long moved[] = { now->pid, was->state, now->state };
+            trace_event(TRACE_DELTA_STATE, i, sim_ns, moved, 3);
+        }
+        *was = *now;
+    }
+}
+
+// ------------------------------------------------------------------------
+static void accumulate_counters(struct CounterTotals *totals, const struct WorkerCounters *ctr) {
+    totals->workers++;
+    totals->clock_reads     += ctr->clock_reads;
+    totals->loop_iterations += ctr->loop_iterations;
+    if (ctr->done) {
+        totals->overshoots++;
+        totals->overshoot_sum_ns += ctr->overshoot_ns;
+        if (ctr->overshoot_ns > totals->overshoot_max_ns) totals->overshoot_max_ns = ctr->overshoot_ns;
+    }
+    if (ctr->attach_real_ns) {
+        long long startup = ctr->attach_real_ns - ctr->spawn_real_ns;
+        totals->startups++;
+        totals->startup_sum_ns += startup;
+        if (startup > totals->startup_max_ns) totals->startup_max_ns = startup;
+    }
+}
+
+// Keep what wait4() said about a worker in its PCB and in the usage histograms
+static void record_usage(struct PCB *pcb, int status, const struct rusage *ru) {
+    long long *v       = pcb->usage.values;
+    pcb->exit_status   = status;
+    v[USAGE_USER_CPU]  = (long long)ru->ru_utime.tv_sec * 1000000LL + ru->ru_utime.tv_usec;
+    v[USAGE_SYS_CPU]   = (long long)ru->ru_stime.tv_sec * 1000000LL + ru->ru_stime.tv_usec;
+    v[USAGE_MAX_RSS]   = ru->ru_maxrss;  // KiB on Linux
+    v[USAGE_VOL_CSW]   = ru->ru_nvcsw;
+    v[USAGE_INVOL_CSW] = ru->ru_nivcsw;
+    for (int k = 0; k < USAGE_KIND_COUNT; k++) {
+        hist_record(&usage_hist[k], v[k]);
+        usage_total[k] += v[k];
+    }
+}
+
+// Free a PCB slot whose worker has been waited on
+static void reap_slot(int slot, int status, const struct rusage *ru) {
+    const struct WorkerCounters *ctr = &segment->counters[slot];
+    long long now_real = monotonic_ns();
+    accumulate_counters(&reaped_totals, ctr);
+    record_usage(&processTable[slot], status, ru);
+    if (ctr->attach_real_ns > 0 && ctr->spawn_real_ns > 0) {
+        hist_record(&latency[LAT_SPAWN_ATTACH], ctr->attach_real_ns - ctr->spawn_real_ns);
+    }
+    if (ctr->exit_real_ns > 0) {
+        hist_record(&latency[LAT_EXIT_REAP], now_real - ctr->exit_real_ns);
+    }
+    if (ctr->done) {
+        hist_record(&latency[LAT_OVERSHOOT], ctr->overshoot_ns);
+    }
+    if (perf_enabled && perf_sample_valid(&segment->perf[slot])) {
+        perf_sample_add(&worker_perf_total, &segment->perf[slot]);
+        worker_perf_count++;
+    }
+    if (timeline_enabled()) {
+        const struct PCB *pcb = &processTable[slot];
+        timeline_worker(slot, pcb->pid, (long long)pcb->startSec * 1000000000LL + pcb->startNano,
+                        (long long)sys_clock->sec * 1000000000LL + sys_clock->nano,
+                        ctr->spawn_real_ns, now_real);
+    }
+    if (dispatcher_count > 0) {
+        // Its dispatcher may still hold the slot (queued, or waiting on a
+        // reply); the slot is freed once it lets go (free_retired_slots)
+        dispatch_release(slot);
+        if (!dispatch_retired(slot)) {
+            retiring[slot]           = 1;
+            processTable[slot].state = PCB_STOPPING;
+            publish_slot(slot);
+            return;
+        }
+    } else if (sched_mode) {
+        // A worker can reply and exit before we look; settle its last quantum first
+        if (running_slot == slot && wait_dispatch_reply(segment, slot, &reply_seen[slot], 0)) {
+            finish_dispatch(slot);
+        }
+        mlfq_remove(&mlfq, slot);
+        if (running_slot == slot) running_slot = -1;
+        if (resource_classes > 0) {
+            resmgr_release_all(&resources, slot);
+            grant_waiting_workers();
+        }
+        if (paging_policy >= 0) pager_release(&pager, slot);
+        for (int d = 0; d < io_device_count; d++) iodev_cancel(&io_devices[d], slot);
+    }
+    processTable[slot].occupied = 0;
+    processTable[slot].state    = PCB_EMPTY;
+    publish_slot(slot);
+    publish_status();
+}
+
+// Summarize worker counters: reaped workers plus (optionally) live ones
+static void emit_counter_totals(int type, int include_live) {
+    struct CounterTotals t = reaped_totals;
+    if (include_live) {
+        for (int i = 0; i < MAX_PROCESSES; i++) {
+            if (processTable[i].occupied) accumulate_counters(&t, &segment->counters[i]);
+        }
+    }
+    const long long args[] = {
+        t.workers,
+        (long long)t.clock_reads,
+        (long long)t.loop_iterations,
+        t.startups ? t.startup_sum_ns / t.startups / 1000 : 0,
+        t.startup_max_ns / 1000,
+        t.overshoots ? t.overshoot_sum_ns / t.overshoots : 0,
+        t.overshoot_max_ns,
+    };
+    trace_event(type, -1, (long long)sys_clock->sec * 1000000000LL + sys_clock->nano, args, 7);
+}
+
+// One line per histogram: count, min, percentiles and max
+static void emit_latency_histograms(void) {
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    for (int k = 0; k < LAT_KIND_COUNT; k++) {
+        const struct LatencyHist *h = &latency[k];
+        const long long args[] = {
+            k,
+            (long long)h->count,
+            h->min,
+            hist_percentile(h, 50.0),
+            hist_percentile(h, 90.0),
+            hist_percentile(h, 99.0),
+            hist_percentile(h, 99.9),
+            h->max,
+        };
+        trace_event(TRACE_LATENCY, -1, sim_ns, args, 8);
+    }
+}
+
+// One line per enum UsageKind: total over reaped workers and the spread
+static void emit_usage_summary(void) {
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    for (int k = 0; k < USAGE_KIND_COUNT; k++) {
+        const struct LatencyHist *h = &usage_hist[k];
+        if (h->count == 0) return;
+        const long long args[] = {
+            k,
+            (long long)h->count,
+            usage_total[k],
+            h->min,
+            hist_percentile(h, 50.0),
+            hist_percentile(h, 90.0),
+            hist_percentile(h, 99.0),
+            h->max,
+        };
+        trace_event(TRACE_USAGE, -1, sim_ns, args, 8);
+    }
+}
+
+// -e: the oss loop's own counters, then the workers' summed
+static void emit_perf_counters(void) {
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    struct PerfSample mine;
+    perf_sample_clear(&mine);
+    if (oss_perf_open) {
+        perf_counters_read(&oss_perf, &mine);
+        perf_counters_close(&oss_perf);
+        oss_perf_open = 0;
+    }
+    const struct PerfSample *samples[] = { &mine, &worker_perf_total };
+    const long long scopes[] = { PERF_SCOPE_OSS, PERF_SCOPE_WORKERS };
+    const long long procs[] = { 1, worker_perf_count };
+    for (int i = 0; i < 2; i++) {
+        const long long *v = samples[i]->values;
+        const long long args[] = {
+            scopes[i],
+            procs[i],
+            v[PERF_CYCLES],
+            v[PERF_INSTRUCTIONS],
+            v[PERF_CACHE_MISSES],
+            v[PERF_CONTEXT_SWITCHES],
+            v[PERF_TASK_CLOCK],
+        };
+        trace_event(TRACE_PERF, -1, sim_ns, args, 7);
+    }
+}
+
+// ------------------------------------------------------------------------
+// -m: one scheduling step per loop pass. Collect the running worker's reply
+// (waiting briefly for it), wake blocked workers that are due, and dispatch
+// the highest-priority ready worker. With nobody ready the clock jumps to
+// the next wakeup or spawn.
+static void schedule_step(long long next_spawn_ns) {
+    if (running_slot >= 0) {
+        if (!wait_dispatch_reply(segment, running_slot, &reply_seen[running_slot], REPLY_WAIT_NS)) return;
+        finish_dispatch(running_slot);
+        running_slot = -1;
+    }
+
+    long long now_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    mlfq_wake_due(&mlfq, now_ns);
+    mlfq_maybe_boost(&mlfq, now_ns);
+    if (resource_classes > 0 && now_ns - last_detect_ns >= RES_DETECT_NS) {
+        resolve_deadlocks(now_ns);
+    }
+    if (paging_policy == PAGE_LRU && now_ns - last_age_ns >= PAGE_AGE_NS) {
+        pager_age(&pager);
+        last_age_ns = now_ns;
+    }
+
+    int slot = mlfq_pick(&mlfq);
+    if (slot >= 0) {
+        increment_clock(sys_clock, DISPATCH_OVERHEAD_NS);
+        post_dispatch(segment, slot, mlfq_quantum(&mlfq, slot));
+        running_slot = slot;
+        publish_slot(slot);
+        return;
+    }
+
+    // Idle: skip ahead to whatever happens next
+    long long next_ns = mlfq_next_wakeup(&mlfq);
+    if (next_spawn_ns >= 0 && (next_ns < 0 || next_spawn_ns < next_ns)) next_ns = next_spawn_ns;
+    if (resource_classes > 0 && resmgr_has_waiting(&resources) &&
+        (next_ns < 0 || last_detect_ns + RES_DETECT_NS < next_ns)) {
+        next_ns = last_detect_ns + RES_DETECT_NS;  // the waiters may be deadlocked
+    }
+    long long idle_ns = next_ns > now_ns ? next_ns - now_ns : current_increment;
+    increment_clock(sys_clock, idle_ns);
+    mlfq.stats.idle_ns += idle_ns;
+}
+
+// Charge the clock for the quantum the worker used and requeue it
+static void finish_dispatch(int slot) {
+    const struct WorkerReply *r = &segment->replies[slot];
+    long long used_ns = r->used_ns > 0 ? r->used_ns : 0;
+    increment_clock(sys_clock, used_ns);
+    mlfq.stats.busy_ns += used_ns;
+    processTable[slot].service_ns += used_ns;
+
+    long long now_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    switch (r->outcome) {
+    case DISPATCH_BLOCKED:
+        mlfq_block(&mlfq, slot, now_ns + r->block_ns);
+        break;
+    case DISPATCH_EXITED:
+        mlfq_remove(&mlfq, slot);
+        mlfq.stats.exits++;
+        break;
+    case DISPATCH_REQUEST:
+        if (resmgr_request(&resources, slot, r->resource, r->count)) {
+            mlfq_requeue(&mlfq, slot);
+        } else {
+            mlfq_wait(&mlfq, slot);
+        }
+        break;
+    case DISPATCH_RELEASE:
+        resmgr_release(&resources, slot, r->resource, r->count);
+        mlfq_requeue(&mlfq, slot);
+        grant_waiting_workers();
+        break;
+    case DISPATCH_MEMORY: {
+        // The address comes unchecked from the segment: read it once, and
+        // ignore one outside the address space like a bad device below
+        unsigned int address = r->address;
+        if ((address >> pager.page_shift) >= (unsigned int)pager.pages) {
+            mlfq_requeue(&mlfq, slot);
+            break;
+        }
+        // A hit goes on at once; a fault waits for the paging device
+        if (pager_access(&pager, slot, address, r->write)) {
+            increment_clock(sys_clock, PAGE_HIT_NS);
+            mlfq_requeue(&mlfq, slot);
+        } else {
+            struct PageFault fault;
+            pager_fault(&pager, slot, address, r->write, &fault);
+            mlfq_block(&mlfq, slot, pager_io(&pager, now_ns, fault.writeback));
+        }
+        break;
+    }
+    case DISPATCH_IO:
+        if (r->device < 0 || r->device >= io_device_count) {
+            mlfq_requeue(&mlfq, slot);
+            break;
+        }
+        mlfq_wait(&mlfq, slot);
+        iodev_submit(&io_devices[r->device], &mlfq.calendar, now_ns, slot, processTable[slot].wake_token,
+                     r->cylinder);
+        break;
+    default:
+        mlfq_preempted(&mlfq, slot);
+        break;
+    }
+    publish_slot(slot);
+}
+
+// -R: wake the workers whose requests fit now
+static void grant_waiting_workers(void) {
+    int granted[MAX_PROCESSES];
+    int n = resmgr_grant_waiting(&resources, granted);
+    for (int i = 0; i < n; i++) {
+        mlfq_unblock(&mlfq, granted[i]);
+        publish_slot(granted[i]);
+    }
+}
+
+// -R: run deadlock detection and terminate workers until it comes back
+// clean. Each round the deadlocked worker holding the most instances goes,
+// and what it held is handed to whoever waits for it.
+static void resolve_deadlocks(long long now_ns) {
+    unsigned long long deadlocked[(MAX_PROCESSES + 63) / 64];
+    int count;
+    last_detect_ns = now_ns;
+    while ((count = resmgr_detect(&resources, deadlocked)) > 0) {
+        int victim = -1, most = -1;
+        for (int i = 0; i < MAX_PROCESSES; i++) {
+            if (!(deadlocked[i / 64] & (1ULL << (i % 64)))) continue;
+            int held = resmgr_held(&resources, i);
+            if (held > most) {
+                victim = i;
+                most   = held;
+            }
+        }
+        const long long args[] = { count, processTable[victim].pid, most };
+        trace_event(TRACE_DEADLOCK, victim, now_ns, args, 3);
+        resources.stats.victims++;
+
+        resmgr_release_all(&resources, victim);
+        mlfq_remove(&mlfq, victim);
+        processTable[victim].state = PCB_STOPPING;
+        publish_slot(victim);
+        post_command(segment, victim, CMD_TERMINATE);
+        grant_waiting_workers();
+    }
+}
+
+static void emit_resource_stats(void) {
+    const struct ResourceStats *st = &resources.stats;
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    const long long use[] = {
+        resources.classes,
+        resources.instances,
+        (long long)st->requests,
+        (long long)st->immediate,
+        (long long)st->queued,
+        (long long)st->releases,
+    };
+    trace_event(TRACE_RESOURCES, -1, sim_ns, use, 6);
+    const long long detect[] = {
+        (long long)st->detections,
+        (long long)st->deadlocks,
+        (long long)st->victims,
+        st->detections ? st->detect_total_ns / (long long)st->detections : 0,
+        st->detect_max_ns,
+    };
+    trace_event(TRACE_DEADLOCK_STATS, -1, sim_ns, detect, 5);
+    resmgr_free(&resources);
+}
+
+static void emit_paging_stats(void) {
+    const struct PagerStats *st = &pager.stats;
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    const long long use[] = {
+        pager.policy,
+        pager.frames,
+        pager_resident(&pager),
+        (long long)st->references,
+        (long long)st->faults,
+        (long long)st->evictions,
+        (long long)st->writebacks,
+    };
+    trace_event(TRACE_PAGING, -1, sim_ns, use, 7);
+    const long long device[] = {
+        (long long)st->device_ops,
+        st->faults ? st->queue_wait_ns / (long long)st->faults : 0,
+        st->queue_wait_max_ns,
+    };
+    trace_event(TRACE_PAGING_DEVICE, -1, sim_ns, device, 3);
+    pager_free(&pager);
+}
+
+// -I: a device finished a request. Wake its worker unless that one is gone
+// (the token no longer matches), and the device moves on by itself.
+static void io_completed(const struct CalendarEvent *ev) {
+    if (ev->type != EV_IO_COMPLETE || ev->arg < 0 || ev->arg >= io_device_count) return;
+    struct IoRequest done;
+    iodev_complete(&io_devices[ev->arg], &mlfq.calendar, ev->time_ns, &done);
+    const struct PCB *pcb = &processTable[done.slot];
+    if (pcb->queue == SQ_BLOCKED && pcb->wake_token == done.token) {
+        mlfq_unblock(&mlfq, done.slot);
+        publish_slot(done.slot);
+    }
+}
+
+static void emit_io_stats(void) {
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    for (int d = 0; d < io_device_count; d++) {
+        const struct IoStats *st = &io_devices[d].stats;
+        long long started = (long long)(st->completed + (io_devices[d].busy ? 1 : 0));
+        const long long args[] = {
+            d,
+            io_devices[d].policy,
+            (long long)st->completed,
+            started ? st->wait_ns / started : 0,
+            started ? st->service_ns / started : 0,
+            st->max_queue,
+            st->service_ns,
+            (long long)st->cylinders,
+        };
+        trace_event(TRACE_IO_DEVICE, -1, sim_ns, args, 8);
+        iodev_free(&io_devices[d]);
+    }
+}
+
+static void emit_sched_stats(void) {
+    const struct SchedStats *st = &mlfq.stats;
+    struct SchedStats sharded;
+    long long sim_ns  = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    if (dispatcher_count > 0) {
+        dispatch_totals(&sharded);
+        st = &sharded;
+        for (int d = 0; d < dispatch_count(); d++) {
+            struct SchedStats mine;
+            unsigned long long steals;
+            dispatch_thread_stats(d, &mine, &steals);
+            const long long args[] = {
+                d,
+                (long long)mine.dispatches,
+                (long long)steals,
+                (long long)mine.preemptions,
+                (long long)mine.blocks,
+                (long long)mine.exits,
+                mine.busy_ns,
+            };
+            trace_event(TRACE_DISPATCHER, -1, sim_ns, args, 7);
         }
     }
-    printf("\n");
+    long long real_ns = monotonic_ns() - ((long long)real_start.tv_sec * 1000000000LL + real_start.tv_nsec);
+    const long long args[] = {
+        (long long)st->dispatches,
+        real_ns > 0 ? (long long)((double)st->dispatches * 1e9 / (double)real_ns) : 0,
+        (long long)st->preemptions,
+        (long long)st->blocks,
+        (long long)st->exits,
+        (long long)st->boosts,
+        st->busy_ns,
+        st->idle_ns,
+    };
+    trace_event(TRACE_SCHED, -1, sim_ns, args, 8);
+
+    long long levels[MLFQ_LEVELS];
+    for (int l = 0; l < MLFQ_LEVELS; l++) {
+        levels[l] = (long long)st->level_dispatches[l];
+    }
+    trace_event(TRACE_SCHED_LEVELS, -1, sim_ns, levels, MLFQ_LEVELS);
+    if (dispatcher_count == 0) mlfq_free(&mlfq);
+}
+
+// -s auto: let the controller revisit the ceiling (it acts once per
+// AUTOSCALE_PERIOD_NS) and report when it moves
+static void autoscale_tick(long long real_ns) {
+    int active = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processTable[i].occupied) active++;
+    }
+    long long sim_ns = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    int old = simul;
+    // Under -m the clock follows dispatched work, so its pace says nothing
+    simul = autoscale_step(&autoscale, real_ns, sim_ns, !sched_mode, active, launched_count < num_workers);
+    if (simul == old) return;
+
+    const long long args[] = {
+        old,
+        simul,
+        autoscale.ratio < 0.0 ? -1 : (long long)(autoscale.ratio * 1000.0),
+        autoscale.pressure < 0.0 ? -1 : (long long)(autoscale.pressure * 1000.0),
+        active,
+        autoscale.cpus,
+    };
+    trace_event(TRACE_AUTOSCALE, -1, sim_ns, args, 6);
+    publish_status();
+}
+
+static void emit_autoscale_summary(void) {
+    long long sim_ns  = (long long)sys_clock->sec * 1000000000LL + sys_clock->nano;
+    long long real_ns = monotonic_ns() - ((long long)real_start.tv_sec * 1000000000LL + real_start.tv_nsec);
+    const long long args[] = {
+        simul,
+        autoscale.min_seen,
+        autoscale.max_seen,
+        autoscale.changes,
+        reaped_totals.workers,
+        real_ns / 1000000,
+    };
+    trace_event(TRACE_AUTOSCALE_SUMMARY, -1, sim_ns, args, 6);
+}
+
+// ------------------------------------------------------------------------
+static void occupied_slots(int *occupied) {
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        occupied[i] = processTable[i].occupied;
+    }
+}
+
+// Mirror a PCB into the segment for osstop
+static void publish_slot(int slot) {
+    struct PcbView *view = &segment->pcbs[slot];
+    const struct PCB *pcb = &processTable[slot];
+    seqlock_write_begin(&view->seq);
+    view->state     = pcb->state;
+    view->pid       = pcb->pid;
+    view->startSec  = pcb->startSec;
+    view->startNano = pcb->startNano;
+    view->cpu       = pcb->cpu;
+    seqlock_write_end(&view->seq);
+}
+
+static void publish_status(void) {
+    struct OssStatus *st = &segment->status;
+    int active           = active_workers();
+    seqlock_write_begin(&st->seq);
+    st->simul           = simul;
+    st->num_workers     = num_workers;
+    st->active          = active;
+    st->launched        = launched_count;
+    st->task_threads    = task_threads;
+    st->increment       = current_increment;
+    st->ratio           = last_ratio;
+    st->real_elapsed_ns = real_start.tv_sec ? monotonic_ns() - ((long long)real_start.tv_sec * 1000000000LL +
+                                                                real_start.tv_nsec)
+                                            : 0;
+    seqlock_write_end(&st->seq);
+}
+
+static void on_report_signal(int signum) {
+    if (signum == SIGUSR1) {
+        histograms_requested = 1;
+    } else {
+        report_requested = 1;
+    }
+}
+
+// Workers running now: occupied PCBs, or live tasks under -L
+static int active_workers(void) {
+    if (task_threads > 0) return taskpool_active();
+    int active = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        if (processTable[i].occupied) active++;
+    }
+    return active;
+}
+
+// -L: print a task's line as its worker would, and fold a finished task
+// into the totals the way reap_slot() does for a process
+static void on_task_event(const struct TaskEvent *ev) {
+    trace_event_pid(TASK_PID_BASE + ev->id, ev->type, -1, ev->sim_ns, ev->args, ev->argc);
+    if (ev->type != TRACE_WORKER_TERMINATE && ev->type != TRACE_WORKER_STOPPED) return;
+
+    struct WorkerCounters ctr;
+    memset(&ctr, 0, sizeof(ctr));
+    ctr.clock_reads     = ev->reads;
+    ctr.loop_iterations = ev->reads;
+    ctr.spawn_real_ns   = ev->spawn_real_ns;
+    ctr.attach_real_ns  = ev->start_real_ns;
+    ctr.done            = ev->type == TRACE_WORKER_TERMINATE;
+    ctr.overshoot_ns    = ev->overshoot_ns;
+    accumulate_counters(&reaped_totals, &ctr);
+    hist_record(&latency[LAT_SPAWN_ATTACH], ev->start_real_ns - ev->spawn_real_ns);
+    if (ctr.done) hist_record(&latency[LAT_OVERSHOOT], ev->overshoot_ns);
+    timeline_task(ev->thread, TASK_PID_BASE + ev->id, ev->start_sim_ns, ev->sim_ns, ev->spawn_real_ns, ev->real_ns);
 }
 
 // ------------------------------------------------------------------------
 static void kill_all_children(void) {
+    int occupied[MAX_PROCESSES];
+    int remaining = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        occupied[i] = processTable[i].occupied;
+        remaining += occupied[i];
+    }
+    if (remaining == 0 || !segment) return;
+
+    // One pass over the channels and a single wake for everyone
+    long long t0 = monotonic_ns();
+    broadcast_command(segment, occupied, CMD_TERMINATE);
     for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (processTable[i].occupied) {
-            kill(processTable[i].pid, SIGTERM);
+        if (occupied[i]) {
+            processTable[i].state = PCB_STOPPING;
+            publish_slot(i);
         }
     }
-    // Final reap
-    int status;
-    while (waitpid(-1, &status, WNOHANG) > 0) { }
+
+    // Reap until everyone is gone; past the grace period SIGKILL the rest
+    int killed = 0;
+    while (remaining > 0) {
+        int status;
+        struct rusage ru;
+        pid_t cpid = wait4(-1, &status, killed ? 0 : WNOHANG, &ru);
+        if (cpid > 0) {
+            remaining -= reap_pid(cpid, status, &ru);
+            continue;
+        }
+        if (cpid == -1 && errno != EINTR) break;  // ECHILD: nothing left to wait for
+        if (!killed && monotonic_ns() - t0 >= SHUTDOWN_GRACE_NS) {
+            for (int i = 0; i < MAX_PROCESSES; i++) {
+                // -M: a slot still PCB_SPAWNING has no pid yet, and kill(0) would hit our own group
+                if (processTable[i].occupied && processTable[i].pid > 0) kill(processTable[i].pid, SIGKILL);
+            }
+            killed = 1;
+        } else if (!killed) {
+            sched_yield();  // let workers run their exit path
+        }
+    }
+    logger_printf("OSS: shutdown of running workers took %.3f ms%s\n",
+                  (double)(monotonic_ns() - t0) / 1e6, killed ? " (some needed SIGKILL)" : "");
 }
 
 // ------------------------------------------------------------------------
 static void cleanup_and_exit(void) {
+    if (oss_perf_open) perf_counters_disable(&oss_perf);  // shutdown is not part of the loop
+    if (task_threads > 0) {
+        // Tasks still running report as stopped, like workers sent CMD_TERMINATE
+        taskpool_stop();
+    }
+    if (threaded_mode) {
+        // Join the helpers and take back what they left queued; from here
+        // on this thread forks nothing and reaps with wait4() itself
+        procthreads_stop();
+        collect_thread_events();
+    }
+    if (dispatcher_count > 0) {
+        // Joined dispatchers hold no slots, so every reaped one can go
+        dispatch_stop();
+        free_retired_slots();
+    }
     kill_all_children();
 
-    if (sys_clock) {
-        detach_shared_memory((void *)sys_clock);
+    if (segment) {
+        emit_counter_totals(TRACE_TOTALS, 0);
+        emit_latency_histograms();
+        emit_usage_summary();
+        if (perf_enabled) emit_perf_counters();
+        if (sched_mode) emit_sched_stats();
+        if (resource_classes > 0) emit_resource_stats();
+        if (paging_policy >= 0) emit_paging_stats();
+        if (io_device_count > 0) emit_io_stats();
+        if (simul_auto) emit_autoscale_summary();
+    }
+    logger_stop();
+    STAGE_REPORT();
+    if (simul_auto) autoscale_close(&autoscale);
+    worker_log_stop();
+    timeline_close();
+
+    if (segment) {
+        release_shared_segment(segment);
+        detach_shared_memory((void *)segment);
     }
     if (shmid != -1) {
         cleanup_shared_memory(shmid);
     }
     cleanup_shared_memory_system();
+    trace_close();
 
     exit(0);
 }
@@ -0,0 +1,163 @@
+/*
+ * osstop: live view of a running oss, in the spirit of top(1).
+ *
+ * Usage: osstop [-i <refresh_ms>] [-n <refreshes>] [-b]
+ *   -i  refresh interval in real milliseconds (default 500)
+ *   -n  stop after this many refreshes (default: until oss exits)
+ *   -b  batch mode: no screen clearing, frames are just appended
+ *
+ * osstop attaches the segment read-only with a bare shmat(SHM_RDONLY),
+ * not the shared.c wrappers, so it never creates or takes the attach
+ * semaphore or writes anything: it cannot slow oss down or corrupt it.
+ * The clock and the OssStatus/PcbView mirrors are seqlocked (read and
+ * retried if oss was mid-update); worker counters are single-writer
+ * words read one at a time.
+ */
+
+// osstop.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/shm.h>
+#include <time.h>
+
+#include "clock.h"
+#include "segment.h"
+#include "shared.h"
+
+#define DEFAULT_REFRESH_MS 500
+#define SNAPSHOT_TRIES     1000
+
+// Reads of a worker's counter block (the worker may be writing it)
+static unsigned long long load_u64(const unsigned long long *p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static long long load_i64(const long long *p) {
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static void usage(FILE *out, const char *prog) {
+    fprintf(out, "Usage: %s [-i <refresh_ms>] [-n <refreshes>] [-b]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int refresh_ms = DEFAULT_REFRESH_MS;
+    int refreshes  = -1;
+    int batch      = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            refresh_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            refreshes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[i], "-h") == 0) {
+            usage(stdout, argv[0]);
+            return 0;
+        } else {
+            usage(stderr, argv[0]);
+            return 1;
+        }
+    }
+    if (refresh_ms <= 0) refresh_ms = DEFAULT_REFRESH_MS;
+
+    int shmid = open_shared_memory(SHM_KEY, sizeof(struct SharedSegment));
+    if (shmid == -1) {
+        fprintf(stderr, "osstop: no oss segment found (is oss running?)\n");
+        return 1;
+    }
+    const struct SharedSegment *seg = shmat(shmid, NULL, SHM_RDONLY);
+    if (seg == (void *)-1) {
+        perror("osstop: shmat");
+        return 1;
+    }
+    if (__atomic_load_n(&seg->header.magic, __ATOMIC_ACQUIRE) != SEGMENT_MAGIC ||
+        seg->header.size != sizeof(struct SharedSegment)) {
+        fprintf(stderr, "osstop: segment is not initialized or has a different layout\n");
+        shmdt(seg);
+        return 1;
+    }
+    unsigned long long generation = segment_generation(seg);
+    pid_t owner = seg->header.owner_pid;
+    unsigned long long owner_start = seg->header.owner_start;
+
+    long long prev_sim_ns = -1, prev_real_ns = 0;
+    struct timespec pause = { refresh_ms / 1000, (long)(refresh_ms % 1000) * 1000000L };
+    for (int frame = 0; refreshes < 0 || frame < refreshes; frame++) {
+        if (frame > 0) nanosleep(&pause, NULL);
+
+        // The owner went away (clean exit clears owner_pid) or a new oss took over
+        if (segment_generation(seg) != generation || !owner_is_alive(owner, owner_start)) {
+            printf("osstop: oss %d is gone\n", (int)owner);
+            break;
+        }
+
+        // Under oss -V the time is worked out from the clock page, not read
+        int sec, nano;
+        long long real_ns = monotonic_ns();
+        long long sim_ns;
+        if (__atomic_load_n(&seg->clock_page.active, __ATOMIC_ACQUIRE)) {
+            sim_ns = clock_page_read(&seg->clock_page, real_ns);
+            sec    = (int)(sim_ns / 1000000000LL);
+            nano   = (int)(sim_ns % 1000000000LL);
+        } else {
+            read_clock(&seg->clock, &sec, &nano);
+            sim_ns = (long long)sec * 1000000000LL + nano;
+        }
+
+        struct OssStatus st;
+        if (!seqlock_read(&seg->status, &st, sizeof(st), SNAPSHOT_TRIES)) {
+            memset(&st, 0, sizeof(st));
+        }
+
+        // Rate over the last refresh, next to the one oss adapts against
+        double live_ratio = 0.0;
+        if (prev_sim_ns >= 0 && real_ns > prev_real_ns) {
+            live_ratio = (double)(sim_ns - prev_sim_ns) / (double)(real_ns - prev_real_ns);
+        }
+        prev_sim_ns  = sim_ns;
+        prev_real_ns = real_ns;
+
+        if (!batch) printf("\033[H\033[2J");
+        printf("oss pid %d  generation %llu  real %.1f s\n", (int)owner, generation,
+               (double)st.real_elapsed_ns / 1e9);
+        printf("clock %d.%09d  ratio %.3f (oss %.3f)  increment %lld ns\n", sec, nano, live_ratio, st.ratio,
+               st.increment);
+        printf("active %d/%d  launched %d/%d", st.active, st.simul, st.launched, st.num_workers);
+        // Tasks have no PCB, so below there are only their counts
+        if (st.task_threads > 0) printf("  (tasks on %d pool threads, no per-task rows)", st.task_threads);
+        printf("\n\n");
+        printf("%-5s %-8s %-8s %-20s %-4s %12s %12s %10s\n", "Slot", "State", "PID", "Start", "CPU",
+               "ClockReads", "Iterations", "Startup_us");
+
+        for (int i = 0; i < MAX_PROCESSES; i++) {
+            struct PcbView view;
+            if (!seqlock_read(&seg->pcbs[i], &view, sizeof(view), SNAPSHOT_TRIES)) continue;
+            if (view.state == PCB_EMPTY) continue;
+
+            const struct WorkerCounters *ctr = &seg->counters[i];
+            long long spawn  = load_i64(&ctr->spawn_real_ns);
+            long long attach = load_i64(&ctr->attach_real_ns);
+            char start[32], cpu[16];
+            snprintf(start, sizeof(start), "%d.%09d", view.startSec, view.startNano);
+            if (view.cpu >= 0) {
+                snprintf(cpu, sizeof(cpu), "%d", view.cpu);
+            } else {
+                snprintf(cpu, sizeof(cpu), "-");
+            }
+            printf("%-5d %-8s %-8d %-20s %-4s %12llu %12llu ", i, pcb_state_name(view.state), (int)view.pid,
+                   start, cpu, load_u64(&ctr->clock_reads), load_u64(&ctr->loop_iterations));
+            if (attach > 0 && spawn > 0) {
+                printf("%10lld\n", (attach - spawn) / 1000);
+            } else {
+                printf("%10s\n", "-");
+            }
+        }
+        fflush(stdout);
+    }
+
+    shmdt(seg);
+    return 0;
+}
@@ -0,0 +1,175 @@
+// pager.c
+
+#include "pager.h"
+#include <stdlib.h>
+#include <string.h>
+
+int page_policy_parse(const char *name) {
+    for (int p = 0; p < PAGE_POLICY_COUNT; p++) {
+        if (strcmp(name, page_policy_name(p)) == 0) return p;
+    }
+    return -1;
+}
+
+int pager_init(struct Pager *pg, int policy, int procs, int pages, int page_shift, int frames) {
+    memset(pg, 0, sizeof(*pg));
+    if (policy < 0 || policy >= PAGE_POLICY_COUNT || procs < 1 || pages < 1 || page_shift < 0 ||
+        page_shift > 31 || frames < 1 || frames > PAGER_MAX_FRAMES ||
+        (unsigned long long)procs * (unsigned long long)pages >= FRAME_FREE) {
+        return -1;
+    }
+    pg->policy      = policy;
+    pg->procs       = procs;
+    pg->pages       = pages;
+    pg->page_shift  = page_shift;
+    pg->frames      = frames;
+    pg->pte         = calloc((size_t)procs * (size_t)pages, sizeof(*pg->pte));
+    pg->frame_page  = malloc((size_t)frames * sizeof(*pg->frame_page));
+    pg->frame_age   = calloc((size_t)frames, sizeof(*pg->frame_age));
+    pg->load_next   = malloc((size_t)frames * sizeof(*pg->load_next));
+    pg->load_prev   = malloc((size_t)frames * sizeof(*pg->load_prev));
+    pg->free_frames = malloc((size_t)frames * sizeof(*pg->free_frames));
+    if (!pg->pte || !pg->frame_page || !pg->frame_age || !pg->load_next || !pg->load_prev || !pg->free_frames) {
+        pager_free(pg);
+        return -1;
+    }
+    // Free frames are taken from the top of the stack, lowest number first
+    for (int f = 0; f < frames; f++) {
+        pg->frame_page[f]  = FRAME_FREE;
+        pg->free_frames[f] = frames - 1 - f;
+    }
+    pg->free_count = frames;
+    pg->load_head = pg->load_tail = -1;
+    return 0;
+}
+
+void pager_free(struct Pager *pg) {
+    free(pg->pte);
+    free(pg->frame_page);
+    free(pg->frame_age);
+    free(pg->load_next);
+    free(pg->load_prev);
+    free(pg->free_frames);
+    pg->pte        = pg->frame_page = NULL;
+    pg->frame_age  = NULL;
+    pg->load_next  = pg->load_prev = pg->free_frames = NULL;
+}
+
+static void load_append(struct Pager *pg, int f) {
+    pg->load_next[f] = -1;
+    pg->load_prev[f] = pg->load_tail;
+    if (pg->load_tail >= 0) {
+        pg->load_next[pg->load_tail] = f;
+    } else {
+        pg->load_head = f;
+    }
+    pg->load_tail = f;
+}
+
+static void load_unlink(struct Pager *pg, int f) {
+    if (pg->load_prev[f] >= 0) {
+        pg->load_next[pg->load_prev[f]] = pg->load_next[f];
+    } else {
+        pg->load_head = pg->load_next[f];
+    }
+    if (pg->load_next[f] >= 0) {
+        pg->load_prev[pg->load_next[f]] = pg->load_prev[f];
+    } else {
+        pg->load_tail = pg->load_prev[f];
+    }
+}
+
+// Pick the frame to take when none is free (every frame is in use)
+static int choose_victim(struct Pager *pg) {
+    switch (pg->policy) {
+    case PAGE_CLOCK:
+        for (;;) {
+            int f       = pg->hand;
+            pg->hand    = f + 1 < pg->frames ? f + 1 : 0;
+            uint32_t *e = &pg->pte[pg->frame_page[f]];
+            if (!(*e & PTE_REF)) return f;
+            *e &= ~PTE_REF;
+        }
+    case PAGE_LRU: {
+        // Lowest age wins. The referenced bit is the interval after the
+        // last tick, so it counts above the whole counter.
+        int victim = -1;
+        unsigned int best = ~0u;
+        for (int i = 0, f = pg->hand; i < pg->frames; i++, f = f + 1 < pg->frames ? f + 1 : 0) {
+            unsigned int key = (pg->pte[pg->frame_page[f]] & PTE_REF ? 0x100u : 0) | pg->frame_age[f];
+            if (key < best) {
+                best   = key;
+                victim = f;
+                if (key == 0) break;
+            }
+        }
+        pg->hand = victim + 1 < pg->frames ? victim + 1 : 0;
+        return victim;
+    }
+    default:
+        return pg->load_head;
+    }
+}
+
+void pager_fault(struct Pager *pg, int proc, uint32_t addr, int write, struct PageFault *out) {
+    uint32_t index = (uint32_t)proc * (uint32_t)pg->pages + (addr >> pg->page_shift);
+    pg->stats.faults++;
+    out->victim_proc = out->victim_page = -1;
+    out->writeback   = 0;
+
+    int f;
+    if (pg->free_count > 0) {
+        f = pg->free_frames[--pg->free_count];
+    } else {
+        f           = choose_victim(pg);
+        uint32_t *e = &pg->pte[pg->frame_page[f]];
+        out->victim_proc = (int)(pg->frame_page[f] / (uint32_t)pg->pages);
+        out->victim_page = (int)(pg->frame_page[f] % (uint32_t)pg->pages);
+        out->writeback   = (*e & PTE_DIRTY) != 0;
+        *e               = 0;
+        load_unlink(pg, f);
+        pg->stats.evictions++;
+        if (out->writeback) pg->stats.writebacks++;
+    }
+
+    pg->frame_page[f] = index;
+    pg->frame_age[f]  = 0;
+    pg->pte[index]    = PTE_VALID | PTE_REF | (write ? PTE_DIRTY : 0) | (uint32_t)f;
+    load_append(pg, f);
+    out->frame = f;
+}
+
+long long pager_io(struct Pager *pg, long long now_ns, int writeback) {
+    long long start = pg->device_free_ns > now_ns ? pg->device_free_ns : now_ns;
+    long long wait  = start - now_ns;
+    pg->stats.queue_wait_ns += wait;
+    if (wait > pg->stats.queue_wait_max_ns) pg->stats.queue_wait_max_ns = wait;
+    pg->stats.device_ops += writeback ? 2 : 1;
+    pg->device_free_ns = start + (writeback ? PAGER_WRITE_NS : 0) + PAGER_READ_NS;
+    return pg->device_free_ns;
+}
+
+void pager_age(struct Pager *pg) {
+    for (int f = 0; f < pg->frames; f++) {
+        if (pg->frame_page[f] == FRAME_FREE) continue;
+        uint32_t *e      = &pg->pte[pg->frame_page[f]];
+        pg->frame_age[f] = (unsigned char)(pg->frame_age[f] >> 1 | ((*e & PTE_REF) ? 0x80 : 0));
+        *e &= ~PTE_REF;
+    }
+}
+
+void pager_release(struct Pager *pg, int proc) {
+    uint32_t *table = &pg->pte[(size_t)proc * (size_t)pg->pages];
+    for (int page = 0; page < pg->pages; page++) {
+        if (!(table[page] & PTE_VALID)) continue;
+        int f             = (int)(table[page] & PTE_FRAME);
+        table[page]       = 0;
+        pg->frame_page[f] = FRAME_FREE;
+        load_unlink(pg, f);
+        pg->free_frames[pg->free_count++] = f;
+    }
+}
+
+int pager_resident(const struct Pager *pg) {
+    return pg->frames - pg->free_count;
+}
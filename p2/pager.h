@@ -0,0 +1,134 @@
+// pager.h
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Paging simulator for oss -P. Every process has a page table of
+ * PAGER_PAGES pages; physical memory is a global table of frames shared
+ * by all of them. A reference to a resident page is a hit. A reference to
+ * any other page faults: the page gets a free frame or evicts one chosen
+ * by the replacement policy, and the faulting process waits for the
+ * paging device. A dirty victim is written back first, so write-backs
+ * queue on the device ahead of the read and delay every fault behind
+ * them. Device time is sim time.
+ *
+ * The page tables are one array of 32-bit entries, [proc * pages + page],
+ * with the valid, referenced and dirty bits next to the frame number the
+ * way a hardware PTE has them, so a hit reads and writes one word. The
+ * frame table is structure-of-arrays: which PTE owns each frame, its age
+ * (LRU approximation), and the links of the load-order list (FIFO).
+ *
+ * Policies:
+ *   fifo  - evict the frame loaded longest ago
+ *   clock - second chance: the hand clears referenced bits until it
+ *           finds a frame without one
+ *   lru   - aging: pager_age() shifts each frame's referenced bit into
+ *           an 8-bit counter; the lowest counter goes
+ */
+
+enum PagePolicy {
+  PAGE_FIFO = 0,
+  PAGE_CLOCK,
+  PAGE_LRU,
+  PAGE_POLICY_COUNT
+};
+
+#define PTE_VALID  0x80000000u
+#define PTE_REF    0x40000000u
+#define PTE_DIRTY  0x20000000u
+#define PTE_FRAME  0x00ffffffu  // frame number of a valid entry
+#define FRAME_FREE 0xffffffffu  // frame_page[] of an unused frame
+
+#define PAGER_MAX_FRAMES (1 << 24)
+
+#define PAGER_READ_NS  14000000LL  // sim ns to read a page in
+#define PAGER_WRITE_NS 14000000LL  // sim ns to write a dirty page back
+
+// Set by oss -P ("pages:page_shift"); workers then issue memory references
+#define PAGER_ENV "OSS_PAGING"
+
+struct PagerStats {
+  unsigned long long references;
+  unsigned long long hits;
+  unsigned long long faults;
+  unsigned long long evictions;     // faults that had to take a frame from a page
+  unsigned long long writebacks;    // evicted dirty pages written back
+  unsigned long long device_ops;    // reads plus write-backs on the paging device
+  long long queue_wait_ns;          // sim time faults waited behind earlier device work
+  long long queue_wait_max_ns;
+};
+
+struct Pager {
+  int policy;                    // enum PagePolicy
+  int procs;
+  int pages;                     // per process
+  int page_shift;                // log2 of the page size
+  int frames;
+  int free_count;
+  uint32_t *pte;                 // [proc * pages + page]
+  uint32_t *frame_page;          // [frame] index of the owning PTE, or FRAME_FREE
+  unsigned char *frame_age;      // [frame] aging counter (lru)
+  int *load_next;                // [frame] load-order list, oldest first (fifo)
+  int *load_prev;
+  int load_head;
+  int load_tail;
+  int *free_frames;              // stack of free_count frames
+  int hand;                      // clock hand, and where the lru scan starts
+  long long device_free_ns;      // sim time the paging device has finished everything queued
+  struct PagerStats stats;
+};
+
+// Where a fault put the page
+struct PageFault {
+  int frame;
+  int victim_proc;  // -1 if the frame was free
+  int victim_page;
+  int writeback;    // the victim was dirty
+};
+
+static inline const char *page_policy_name( int policy ) {
+  static const char *names[PAGE_POLICY_COUNT] = { "fifo", "clock", "lru" };
+  return policy >= 0 && policy < PAGE_POLICY_COUNT ? names[policy] : "?";
+}
+
+// enum PagePolicy for a name, or -1
+int page_policy_parse( const char *name );
+
+// Allocate the tables, every frame free; -1 on bad sizes or no memory
+int pager_init( struct Pager *pg, int policy, int procs, int pages, int page_shift, int frames );
+void pager_free( struct Pager *pg );
+
+// Reference addr (below pages << page_shift) in proc's address space.
+// 1 on a hit (marks the page referenced, and dirty on a write); 0 if the
+// page is not resident and pager_fault() has to bring it in.
+static inline int pager_access( struct Pager *pg, int proc, uint32_t addr, int write ) {
+  uint32_t *e = &pg->pte[(size_t)proc * (size_t)pg->pages + ( addr >> pg->page_shift )];
+  pg->stats.references++;
+  if ( !( *e & PTE_VALID ) ) return 0;
+  *e |= write ? PTE_REF | PTE_DIRTY : PTE_REF;
+  pg->stats.hits++;
+  return 1;
+}
+
+// Load the page behind a missed reference into a frame, evicting one if
+// none is free; the reference itself is then recorded as by a hit
+void pager_fault( struct Pager *pg, int proc, uint32_t addr, int write, struct PageFault *out );
+
+// Queue the device work for a fault at now_ns (the write-back, if any,
+// then the read); returns the sim time the page is in
+long long pager_io( struct Pager *pg, long long now_ns, int writeback );
+
+// LRU aging tick: shift every frame's referenced bit into its counter
+void pager_age( struct Pager *pg );
+
+// The process is gone: free its frames (dirty pages are dropped)
+void pager_release( struct Pager *pg, int proc );
+
+// Frames in use
+int pager_resident( const struct Pager *pg );
+
+#endif /* PAGER_H */
@@ -0,0 +1,168 @@
+// pagesim.c
+//
+// Replays memory references through the oss -P paging simulator without
+// oss, to compare the policies on real traces and to time the simulator:
+//   pagesim [-p fifo|clock|lru] [-f frames] [-n procs] [-g pages] [-s page_shift]
+//           [-r refs] [-a age_every] [trace]
+// A trace is text, one reference per line: "<proc> <R|W> <hex address>".
+// Without one, -r synthetic references are generated for -n processes,
+// each mostly touching a small window of pages that drifts over time.
+// The whole trace is loaded first, so only the replay is timed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "pager.h"
+
+#define WINDOW_PAGES    8    // synthetic: pages near the current locus
+#define LOCAL_PERCENT   90   // synthetic: references that stay in the window
+#define WRITE_PERCENT   30
+#define DRIFT_EVERY     1000 // synthetic: references between locus moves
+
+struct Trace {
+    size_t count;
+    size_t capacity;
+    int *proc;
+    uint32_t *addr;
+    unsigned char *write;
+};
+
+static void trace_append(struct Trace *t, int proc, uint32_t addr, int write) {
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity ? t->capacity * 2 : 1 << 16;
+        t->proc     = realloc(t->proc, t->capacity * sizeof(*t->proc));
+        t->addr     = realloc(t->addr, t->capacity * sizeof(*t->addr));
+        t->write    = realloc(t->write, t->capacity * sizeof(*t->write));
+        if (!t->proc || !t->addr || !t->write) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    t->proc[t->count]  = proc;
+    t->addr[t->count]  = addr;
+    t->write[t->count] = (unsigned char)write;
+    t->count++;
+}
+
+// Read "<proc> <R|W> <hex address>" lines; procs and pages grow to fit
+static void load_trace(struct Trace *t, const char *path, int *procs, int *pages, int page_shift) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+    char line[256];
+    size_t lineno = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+        int proc;
+        char op;
+        unsigned long long addr;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (sscanf(line, "%d %c %llx", &proc, &op, &addr) != 3 || proc < 0 || addr > UINT32_MAX ||
+            (op != 'R' && op != 'W' && op != 'r' && op != 'w')) {
+            fprintf(stderr, "pagesim: %s:%zu: bad reference\n", path, lineno);
+            exit(1);
+        }
+        if (proc >= *procs) *procs = proc + 1;
+        int page = (int)(addr >> page_shift);
+        if (page >= *pages) *pages = page + 1;
+        trace_append(t, proc, (uint32_t)addr, op == 'W' || op == 'w');
+    }
+    fclose(in);
+}
+
+static void synthesize(struct Trace *t, long long refs, int procs, int pages, int page_shift) {
+    unsigned int seed = 1;
+    int *locus = calloc((size_t)procs, sizeof(*locus));
+    if (!locus) {
+        perror("calloc");
+        exit(1);
+    }
+    for (long long i = 0; i < refs; i++) {
+        int proc = rand_r(&seed) % procs;
+        if (i % DRIFT_EVERY == 0) locus[proc] = rand_r(&seed) % pages;
+        int page = rand_r(&seed) % 100 < LOCAL_PERCENT ? (locus[proc] + rand_r(&seed) % WINDOW_PAGES) % pages
+                                                        : rand_r(&seed) % pages;
+        uint32_t offset = (uint32_t)rand_r(&seed) & ((1u << page_shift) - 1);
+        trace_append(t, proc, (uint32_t)page << page_shift | offset, rand_r(&seed) % 100 < WRITE_PERCENT);
+    }
+    free(locus);
+}
+
+int main(int argc, char *argv[]) {
+    int policy = PAGE_CLOCK, frames = 256, procs = 18, pages = 32, page_shift = 10, age_every = 1000;
+    long long refs   = 20000000;
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            policy = page_policy_parse(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            procs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            pages = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            page_shift = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            refs = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            age_every = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [-p fifo|clock|lru] [-f frames] [-n procs] [-g pages] [-s page_shift] "
+                    "[-r refs] [-a age_every] [trace]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (policy < 0 || procs < 1 || pages < 1 || page_shift < 0 || page_shift > 31 || refs < 1 || age_every < 1) {
+        fprintf(stderr, "pagesim: bad option value\n");
+        return 1;
+    }
+
+    struct Trace trace = { 0 };
+    if (path) {
+        load_trace(&trace, path, &procs, &pages, page_shift);
+    } else {
+        synthesize(&trace, refs, procs, pages, page_shift);
+    }
+    struct Pager pg;
+    if (pager_init(&pg, policy, procs, pages, page_shift, frames) == -1) {
+        fprintf(stderr, "pagesim: bad sizes or out of memory\n");
+        return 1;
+    }
+
+    // Each reference takes 100 sim ns unless it waits for the device
+    long long sim_ns = 0;
+    int aging        = policy == PAGE_LRU;
+    struct PageFault fault;
+    long long t0 = monotonic_ns();
+    for (size_t i = 0; i < trace.count; i++) {
+        sim_ns += 100;
+        if (!pager_access(&pg, trace.proc[i], trace.addr[i], trace.write[i])) {
+            pager_fault(&pg, trace.proc[i], trace.addr[i], trace.write[i], &fault);
+            sim_ns = pager_io(&pg, sim_ns, fault.writeback);
+        }
+        if (aging && i % (size_t)age_every == 0) pager_age(&pg);
+    }
+    long long real_ns = monotonic_ns() - t0;
+
+    const struct PagerStats *st = &pg.stats;
+    printf("%s, %d frames, %d procs x %d pages of %u bytes: %llu references, %llu faults (%.2f%%), "
+           "%llu write-backs\n",
+           page_policy_name(policy), frames, procs, pages, 1u << page_shift, st->references, st->faults,
+           st->references ? 100.0 * (double)st->faults / (double)st->references : 0.0, st->writebacks);
+    printf("replay: %.3f s real, %.1f M references/s; %.3f s sim\n", (double)real_ns / 1e9,
+           real_ns > 0 ? (double)st->references * 1e3 / (double)real_ns : 0.0, (double)sim_ns / 1e9);
+    pager_free(&pg);
+    free(trace.proc);
+    free(trace.addr);
+    free(trace.write);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// pcb.h
+
+#ifndef PCB_H
+#define PCB_H
+
+#include <sys/types.h>
+
+#include "hist.h"
+
+// What wait4() reported for a reaped worker, indexed by enum UsageKind
+struct WorkerUsage {
+  long long values[USAGE_KIND_COUNT];
+};
+
+// PCB struct for each worker
+struct PCB {
+  int occupied;   // 1 = in use, 0 = free
+  int state;      // enum PcbState
+  pid_t pid;      // child's PID
+  int startSec;   // time (seconds) in the simulation when forked
+  int startNano;  // time (nanoseconds) in the simulation when forked
+  int cpu;        // CPU the worker was pinned to, -1 if unpinned
+
+  // Scheduling (oss -m). The ready and blocked queues are intrusive
+  // doubly linked lists of slot numbers threaded through these fields.
+  int level;                // feedback queue level, 0 = highest priority
+  int queue;                // enum SchedQueue the PCB is linked on
+  int next;                 // next slot on that queue, -1 at the tail
+  int prev;                 // previous slot, -1 at the head
+  unsigned int wake_token;  // identifies the calendar entry of the current block
+  long long service_ns;     // sim CPU time charged to the worker so far
+
+  // Set when the worker is reaped; stays until the slot is reused
+  int exit_status;           // as returned by wait4()
+  struct WorkerUsage usage;  // what the worker cost the host
+};
+
+#endif /* PCB_H */
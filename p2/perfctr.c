@@ -0,0 +1,109 @@
+// perfctr.c
+
+#include "perfctr.h"
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const struct {
+    unsigned int type;
+    unsigned long long config;
+} perf_events[PERF_KIND_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+};
+
+void perf_counters_request(void) {
+    setenv(PERF_ENV, "1", 1);
+}
+
+int perf_counters_requested(void) {
+    const char *v = getenv(PERF_ENV);
+    return v && *v == '1';
+}
+
+int perf_counters_open(struct PerfCounters *pc) {
+    int opened = 0;
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = perf_events[k].type;
+        attr.config         = perf_events[k].config;
+        attr.disabled       = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Context switches happen in the kernel, so software events try
+        // without exclude_kernel first; hardware ones stay user-only
+        attr.exclude_kernel = perf_events[k].type == PERF_TYPE_SOFTWARE ? 0 : 1;
+        pc->fds[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (pc->fds[k] < 0 && !attr.exclude_kernel) {
+            attr.exclude_kernel = 1;
+            pc->fds[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        }
+        if (pc->fds[k] >= 0) opened++;
+    }
+    return opened;
+}
+
+void perf_counters_enable(struct PerfCounters *pc) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        if (pc->fds[k] >= 0) ioctl(pc->fds[k], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters_disable(struct PerfCounters *pc) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        if (pc->fds[k] >= 0) ioctl(pc->fds[k], PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void perf_counters_read(const struct PerfCounters *pc, struct PerfSample *out) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        out->values[k] = -1;
+        if (pc->fds[k] < 0) continue;
+        unsigned long long buf[3];  // value, time_enabled, time_running
+        if (read(pc->fds[k], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue;
+        if (buf[2] == 0) {
+            out->values[k] = 0;
+        } else if (buf[2] < buf[1]) {
+            // The PMU was shared with other events; extrapolate
+            out->values[k] = (long long)((double)buf[0] * (double)buf[1] / (double)buf[2]);
+        } else {
+            out->values[k] = (long long)buf[0];
+        }
+    }
+}
+
+void perf_counters_close(struct PerfCounters *pc) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        if (pc->fds[k] >= 0) close(pc->fds[k]);
+        pc->fds[k] = -1;
+    }
+}
+
+void perf_sample_clear(struct PerfSample *s) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        s->values[k] = -1;
+    }
+}
+
+int perf_sample_valid(const struct PerfSample *s) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        if (s->values[k] >= 0) return 1;
+    }
+    return 0;
+}
+
+void perf_sample_add(struct PerfSample *sum, const struct PerfSample *in) {
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        if (in->values[k] < 0) continue;
+        sum->values[k] = (sum->values[k] < 0 ? 0 : sum->values[k]) + in->values[k];
+    }
+}
@@ -0,0 +1,67 @@
+// perfctr.h
+
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+/*
+ * Self-profiling with perf_event_open(2). oss -e opens counters on
+ * itself around its main loop and exports PERF_ENV so every worker does
+ * the same around its clock-poll loop. Hardware events count user space
+ * only, which works with the default perf_event_paranoid of 2. Events the
+ * host does not support (hardware counters inside most VMs) read as -1.
+ */
+
+#define PERF_ENV "OSS_PERF_COUNTERS"
+
+enum PerfCounterKind {
+  PERF_CYCLES = 0,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_CONTEXT_SWITCHES,
+  PERF_TASK_CLOCK,  // ns on CPU, available even without hardware counters
+  PERF_KIND_COUNT
+};
+
+// Whose counters a TRACE_PERF event carries
+enum PerfScope {
+  PERF_SCOPE_OSS = 0,  // the oss main loop
+  PERF_SCOPE_WORKER,   // one worker's poll loop
+  PERF_SCOPE_WORKERS   // all reaped workers, summed by oss
+};
+
+struct PerfCounters {
+  int fds[PERF_KIND_COUNT];  // -1 where the event could not be opened
+};
+
+// Scaled counter values (-1 = unavailable)
+struct PerfSample {
+  long long values[PERF_KIND_COUNT];
+};
+
+// oss: enable counters for this process and its workers
+void perf_counters_request( void );
+
+// 1 if counters were requested (by oss -e, or through the environment)
+int perf_counters_requested( void );
+
+// Open the counters disabled; returns the number of events opened
+int perf_counters_open( struct PerfCounters *pc );
+
+// Start / stop counting (the hot loop sits between the two)
+void perf_counters_enable( struct PerfCounters *pc );
+void perf_counters_disable( struct PerfCounters *pc );
+
+// Read (scaled for multiplexing) and close
+void perf_counters_read( const struct PerfCounters *pc, struct PerfSample *out );
+void perf_counters_close( struct PerfCounters *pc );
+
+// Mark every value unavailable
+void perf_sample_clear( struct PerfSample *s );
+
+// Add 'in' to 'sum', keeping -1 for events that were never available
+void perf_sample_add( struct PerfSample *sum, const struct PerfSample *in );
+
+// 1 if any counter in 's' was read
+int perf_sample_valid( const struct PerfSample *s );
+
+#endif /* PERFCTR_H */
@@ -0,0 +1,245 @@
+// placement.c
+
+#define _GNU_SOURCE
+#include "placement.h"
+#include <dirent.h>
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int policy_in_use = PLACE_NONE;
+static int oss_cpu       = -1;
+
+// node_of[cpu] for every CPU we are allowed to run on, -1 otherwise
+static int node_of[CPU_SETSIZE];
+
+// Order in which worker slots are mapped onto CPUs
+static int worker_cpus[CPU_SETSIZE];
+static int worker_cpu_count = 0;
+
+int parse_placement_policy(const char *name) {
+    for (int i = 0; i <= PLACE_NODE; i++) {
+        if (strcmp(name, placement_policy_name(i)) == 0) return i;
+    }
+    return -1;
+}
+
+// Mark every CPU in a sysfs cpulist ("0-3,8,10-11") as belonging to 'node'
+static void read_node_cpulist(int node, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    char buf[4096];
+    if (!fgets(buf, sizeof(buf), fp)) {
+        fclose(fp);
+        return;
+    }
+    fclose(fp);
+
+    char *p = buf;
+    while (*p && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p) break;
+        if (*end == '-') {
+            p  = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long cpu = lo; cpu <= hi && cpu < CPU_SETSIZE; cpu++) {
+            if (node_of[cpu] == 0) node_of[cpu] = node;  // only allowed CPUs are >= 0
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+}
+
+static void discover_topology(const cpu_set_t *allowed) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        node_of[cpu] = CPU_ISSET((size_t)cpu, allowed) ? 0 : -1;
+    }
+
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) return;  // no NUMA info => everything on node 0
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        int node;
+        if (sscanf(ent->d_name, "node%d", &node) != 1 || node <= 0) continue;
+        char path[300];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", ent->d_name);
+        read_node_cpulist(node, path);
+    }
+    closedir(dir);
+}
+
+static int max_node(void) {
+    int top = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (node_of[cpu] > top) top = node_of[cpu];
+    }
+    return top;
+}
+
+// Fill worker_cpus[] according to the policy. oss's own CPU goes last so
+// workers only share it with the spinning oss once every other CPU is taken.
+static void build_worker_order(int policy) {
+    int oss_node = placement_node_of(oss_cpu);
+    int nodes    = max_node() + 1;
+    worker_cpu_count = 0;
+
+    if (policy == PLACE_SCATTER) {
+        // Take the next unused CPU of each node in turn
+        int cursor[CPU_SETSIZE];
+        for (int n = 0; n < nodes; n++) cursor[n] = 0;
+        int added;
+        do {
+            added = 0;
+            for (int n = 0; n < nodes; n++) {
+                int cpu = cursor[n];
+                while (cpu < CPU_SETSIZE && (node_of[cpu] != n || cpu == oss_cpu)) cpu++;
+                if (cpu < CPU_SETSIZE) {
+                    worker_cpus[worker_cpu_count++] = cpu;
+                    added = 1;
+                }
+                cursor[n] = cpu + 1;
+            }
+        } while (added);
+    } else {
+        // compact walks nodes starting with oss's; node stops after it
+        for (int i = 0; i < nodes; i++) {
+            int n = (oss_node + i) % nodes;
+            if (policy == PLACE_NODE && n != oss_node) break;
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (node_of[cpu] == n && cpu != oss_cpu) {
+                    worker_cpus[worker_cpu_count++] = cpu;
+                }
+            }
+        }
+    }
+
+    if (oss_cpu >= 0) {
+        worker_cpus[worker_cpu_count++] = oss_cpu;
+    }
+}
+
+void placement_init(int policy) {
+    policy_in_use = policy;
+    if (policy == PLACE_NONE) return;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+        perror("sched_getaffinity");
+        policy_in_use = PLACE_NONE;
+        return;
+    }
+    discover_topology(&allowed);
+
+    // Pin oss to wherever the scheduler started it
+    oss_cpu = sched_getcpu();
+    if (oss_cpu < 0 || oss_cpu >= CPU_SETSIZE || node_of[oss_cpu] < 0) {
+        oss_cpu = -1;
+        for (int cpu = 0; cpu < CPU_SETSIZE && oss_cpu < 0; cpu++) {
+            if (node_of[cpu] >= 0) oss_cpu = cpu;
+        }
+    }
+    if (placement_pin(0, oss_cpu) == -1) {
+        perror("sched_setaffinity oss");
+    }
+
+    build_worker_order(policy);
+}
+
+void placement_bind_memory(void *addr, size_t len) {
+    if (policy_in_use == PLACE_NONE || oss_cpu < 0) return;
+
+    int node = placement_node_of(oss_cpu);
+    unsigned long mask[CPU_SETSIZE / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    mask[(size_t)node / (8 * sizeof(unsigned long))] |= 1UL << ((size_t)node % (8 * sizeof(unsigned long)));
+
+    // Round out to whole pages; MPOL_MF_MOVE migrates anything already faulted in
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned long start = (unsigned long)addr & ~((unsigned long)page - 1);
+    unsigned long span  = ((unsigned long)addr + len - start + (unsigned long)page - 1) & ~((unsigned long)page - 1);
+    if (syscall(SYS_mbind, start, span, MPOL_BIND, mask, (unsigned long)(8 * sizeof(mask)), MPOL_MF_MOVE) == -1 &&
+        errno != ENOSYS) {
+        perror("mbind shared segment");
+    }
+}
+
+int placement_cpu_for_slot(int slot) {
+    if (policy_in_use == PLACE_NONE || worker_cpu_count == 0) return -1;
+    return worker_cpus[slot % worker_cpu_count];
+}
+
+int placement_pin(pid_t pid, int cpu) {
+    if (cpu < 0) return 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((size_t)cpu, &set);
+    return sched_setaffinity(pid, sizeof(set), &set);
+}
+
+int placement_node_of(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return -1;
+    return node_of[cpu];
+}
+
+int placement_oss_cpu(void) {
+    return oss_cpu;
+}
+
+// Last-level cache id of 'cpu': the id of its highest-level cache, -1 if unknown
+static int llc_id_of(int cpu) {
+    int best_level = -1, best_id = -1;
+    for (int index = 0;; index++) {
+        char path[128];
+        int level, id;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        FILE *fp = fopen(path, "r");
+        if (!fp) break;
+        int ok = fscanf(fp, "%d", &level) == 1;
+        fclose(fp);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/id", cpu, index);
+        fp = fopen(path, "r");
+        if (!fp) continue;
+        ok = ok && fscanf(fp, "%d", &id) == 1;
+        fclose(fp);
+        if (ok && level > best_level) {
+            best_level = level;
+            best_id    = id;
+        }
+    }
+    return best_id;
+}
+
+int placement_domains(int kind, int *domain_of, int cpus, int max_domains) {
+    if (policy_in_use == PLACE_NONE) {
+        // placement_init() left the topology alone
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+            for (int cpu = 0; cpu < cpus; cpu++) domain_of[cpu] = 0;
+            return 1;
+        }
+        discover_topology(&allowed);
+    }
+
+    // Raw ids (node number or cache id) get dense numbers in CPU order
+    int raw_ids[CPU_SETSIZE];
+    int count = 0;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        domain_of[cpu] = -1;
+        if (cpu >= CPU_SETSIZE || node_of[cpu] < 0) continue;
+        int raw = kind == DOMAIN_LLC ? llc_id_of(cpu) : node_of[cpu];
+        int dense = 0;
+        while (dense < count && raw_ids[dense] != raw) dense++;
+        if (dense == count) raw_ids[count++] = raw;
+        domain_of[cpu] = dense % max_domains;
+    }
+    return count == 0 ? 1 : count < max_domains ? count : max_domains;
+}
@@ -0,0 +1,62 @@
+// placement.h
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * CPU / NUMA placement of oss, its workers and the shared segment.
+ * oss pins itself to the CPU it is running on, binds the segment's memory
+ * to that CPU's node, and hands each worker a CPU chosen by the policy.
+ * Topology comes from /sys/devices/system/node; hosts without it are
+ * treated as a single node.
+ */
+
+enum PlacementPolicy {
+  PLACE_NONE = 0,  // leave everything to the scheduler (default)
+  PLACE_COMPACT,   // fill the CPUs of one node before moving to the next
+  PLACE_SCATTER,   // round-robin workers across nodes
+  PLACE_NODE       // only use CPUs on the same node as oss
+};
+
+// Cache-sharing domains for placement_domains()
+enum PlacementDomain {
+  DOMAIN_NODE = 0,  // NUMA node
+  DOMAIN_LLC        // last-level cache
+};
+
+// Parse "none", "compact", "scatter" or "node". Returns -1 if unknown.
+int parse_placement_policy( const char *name );
+
+static inline const char *placement_policy_name( int policy ) {
+  static const char *names[PLACE_NODE + 1] = { "none", "compact", "scatter", "node" };
+  return policy >= 0 && policy <= PLACE_NODE ? names[policy] : "?";
+}
+
+// Discover the topology, pin oss and build the worker CPU order.
+void placement_init( int policy );
+
+// Bind [addr, addr+len) to oss's node (no-op for PLACE_NONE)
+void placement_bind_memory( void *addr, size_t len );
+
+// CPU a worker in PCB slot 'slot' should run on, or -1 if unpinned
+int placement_cpu_for_slot( int slot );
+
+// Pin 'pid' to 'cpu' (ignored when cpu < 0). Returns 0 on success.
+int placement_pin( pid_t pid, int cpu );
+
+// NUMA node of 'cpu', or -1 if unknown
+int placement_node_of( int cpu );
+
+// CPU oss pinned itself to, or -1
+int placement_oss_cpu( void );
+
+// Number the 'kind' domains of the CPUs oss may run on densely from 0,
+// folding them into max_domains, and store each CPU's in domain_of[cpu]
+// (-1 for CPUs not allowed) for cpu < cpus. Works whatever the policy;
+// returns the number of domains (1 if the topology is unknown).
+int placement_domains( int kind, int *domain_of, int cpus, int max_domains );
+
+#endif /* PLACEMENT_H */
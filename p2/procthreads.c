@@ -0,0 +1,128 @@
+// procthreads.c
+
+#include "procthreads.h"
+#include "spscq.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+
+// Never more launches or exits in flight than PCB slots, so this never fills
+#define QUEUE_SLOTS    64
+// Upper bound on how long either thread sleeps before rechecking 'stopping'
+#define THREAD_IDLE_NS 100000000LL
+
+static struct SpscQueue spawn_requests;  // main loop -> spawner
+static struct SpscQueue spawn_results;   // spawner -> main loop
+static struct SpscQueue reaped;          // reaper -> main loop
+
+static procthreads_launch_fn launch_worker;
+static pthread_t spawner_thread;
+static pthread_t reaper_thread;
+static int stopping = 0;
+static int running  = 0;
+
+static void *spawner_main(void *unused) {
+    (void)unused;
+    struct SpawnRequest req;
+    while (1) {
+        if (spsc_pop(&spawn_requests, &req)) {
+            struct SpawnResult res = { .slot = req.slot, .cpu = req.cpu, .pid = -1 };
+            // Whatever is still queued at shutdown goes back unlaunched
+            if (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+                res.pid = launch_worker(req.slot, &res.cpu);
+            }
+            spsc_push_wait(&spawn_results, &res);
+            continue;
+        }
+        if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) break;
+        spsc_wait(&spawn_requests, &stopping, THREAD_IDLE_NS);
+    }
+    return NULL;
+}
+
+static void *reaper_main(void *unused) {
+    (void)unused;
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    const struct timespec idle = { 0, THREAD_IDLE_NS };
+
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        // SIGCHLD does not queue, so one signal may stand for several exits
+        for (;;) {
+            struct ReapEvent ev;
+            ev.pid = wait4(-1, &ev.status, WNOHANG, &ev.usage);
+            if (ev.pid <= 0) break;
+            spsc_push_wait(&reaped, &ev);
+        }
+        sigtimedwait(&chld, NULL, &idle);
+    }
+    return NULL;
+}
+
+void procthreads_block_sigchld(void) {
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &chld, NULL);
+}
+
+void procthreads_unblock_sigchld(void) {
+    sigset_t chld;
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &chld, NULL);
+}
+
+int procthreads_start(procthreads_launch_fn launch) {
+    if (spsc_init(&spawn_requests, QUEUE_SLOTS, sizeof(struct SpawnRequest)) == -1 ||
+        spsc_init(&spawn_results, QUEUE_SLOTS, sizeof(struct SpawnResult)) == -1 ||
+        spsc_init(&reaped, QUEUE_SLOTS, sizeof(struct ReapEvent)) == -1) {
+        perror("procthreads queues");
+        return -1;
+    }
+    launch_worker = launch;
+    stopping      = 0;
+
+    int err = pthread_create(&spawner_thread, NULL, spawner_main, NULL);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create spawner: %s\n", strerror(err));
+        return -1;
+    }
+    err = pthread_create(&reaper_thread, NULL, reaper_main, NULL);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create reaper: %s\n", strerror(err));
+        __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+        spsc_kick(&spawn_requests);
+        pthread_join(spawner_thread, NULL);
+        return -1;
+    }
+    running = 1;
+    return 0;
+}
+
+int procthreads_request_spawn(int slot, int cpu) {
+    const struct SpawnRequest req = { slot, cpu };
+    return spsc_push(&spawn_requests, &req);
+}
+
+int procthreads_next_spawned(struct SpawnResult *out) {
+    return running && spsc_pop(&spawn_results, out);
+}
+
+int procthreads_next_reaped(struct ReapEvent *out) {
+    return running && spsc_pop(&reaped, out);
+}
+
+void procthreads_stop(void) {
+    if (!running) return;
+    __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+    spsc_kick(&spawn_requests);
+    pthread_kill(reaper_thread, SIGCHLD);  // pending SIGCHLD ends its sigtimedwait
+    pthread_join(spawner_thread, NULL);
+    pthread_join(reaper_thread, NULL);
+    // The queues stay readable until the process exits
+}
@@ -0,0 +1,65 @@
+// procthreads.h
+
+#ifndef PROCTHREADS_H
+#define PROCTHREADS_H
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+/*
+ * oss -M: the main loop keeps the clock and the process table, and two
+ * helper threads take over the blocking work around it. The spawner
+ * forks and execs workers for slots the loop has already reserved; the
+ * reaper sleeps in sigtimedwait() until SIGCHLD and collects exited
+ * children. Each direction is its own single-producer / single-consumer
+ * queue (spscq.h), and only the main loop ever writes the table, so a
+ * slot is RESERVED -> SPAWNING -> RUNNING -> reaped in that one thread.
+ */
+
+// Main loop -> spawner
+struct SpawnRequest {
+  int slot;
+  int cpu;  // CPU to pin the worker to, -1 for none
+};
+
+// Spawner -> main loop
+struct SpawnResult {
+  int slot;
+  int cpu;    // CPU actually pinned to, -1 if unpinned
+  pid_t pid;  // -1 if the worker was not launched
+};
+
+// Reaper -> main loop
+struct ReapEvent {
+  pid_t pid;
+  int status;           // as returned by wait4()
+  struct rusage usage;  // the child's resource usage
+};
+
+// Forks and execs the worker for 'slot' (pinned to *cpu, which it may
+// reset to -1); returns the pid or -1. Runs on the spawner thread.
+typedef pid_t ( *procthreads_launch_fn )( int slot, int *cpu );
+
+// Block SIGCHLD in the calling thread; call before creating any thread
+// so that only the reaper ever sees it
+void procthreads_block_sigchld( void );
+
+// Undo procthreads_block_sigchld() in a freshly forked child
+void procthreads_unblock_sigchld( void );
+
+// Start the spawner and the reaper
+int procthreads_start( procthreads_launch_fn launch );
+
+// Queue a launch for a reserved slot; 0 if the queue is full
+int procthreads_request_spawn( int slot, int cpu );
+
+// Next finished launch / next exited child; 0 if there is none yet
+int procthreads_next_spawned( struct SpawnResult *out );
+int procthreads_next_reaped( struct ReapEvent *out );
+
+// Stop and join both threads. Requests not yet launched come back from
+// procthreads_next_spawned() with pid -1; children reaped so far are
+// still queued, and later ones are left for the caller to wait4().
+void procthreads_stop( void );
+
+#endif /* PROCTHREADS_H */
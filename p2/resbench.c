@@ -0,0 +1,88 @@
+// resbench.c
+//
+// Times resmgr_detect() on tables far larger than oss runs with:
+//   resbench [procs] [classes] [instances] [runs]
+// (default 1000 processes x 64 classes x 10 instances, 1000 runs). Three
+// states are measured: a random one where about half the processes wait,
+// chains where each process can only finish after the next one has, so
+// the detection pass clears one process per class per sweep, and a cycle
+// over the classes where every process is deadlocked.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "clock.h"
+#include "resmgr.h"
+
+// Run detection 'runs' times; print the average and worst real time
+static void time_detect(const char *name, struct ResourceManager *rm, int runs) {
+    unsigned long long *deadlocked = calloc((size_t)rm->words, sizeof(*deadlocked));
+    if (!deadlocked) {
+        perror("calloc");
+        exit(1);
+    }
+    long long total = 0, worst = 0;
+    int found = 0;
+    for (int i = 0; i < runs; i++) {
+        long long t0 = monotonic_ns();
+        found        = resmgr_detect(rm, deadlocked);
+        long long dt = monotonic_ns() - t0;
+        total += dt;
+        if (dt > worst) worst = dt;
+    }
+    printf("%-8s %d procs x %d classes: deadlocked=%d detect avg=%.1f us max=%.1f us\n", name, rm->procs,
+           rm->classes, found, (double)total / runs / 1e3, (double)worst / 1e3);
+    free(deadlocked);
+}
+
+int main(int argc, char *argv[]) {
+    int procs     = argc > 1 ? atoi(argv[1]) : 1000;
+    int classes   = argc > 2 ? atoi(argv[2]) : RES_MAX_CLASSES;
+    int instances = argc > 3 ? atoi(argv[3]) : 10;
+    int runs      = argc > 4 ? atoi(argv[4]) : 1000;
+    unsigned int seed = 1;
+
+    // Random: hand out instances while they last, then let every other
+    // process ask for something it may not get
+    struct ResourceManager rm;
+    if (resmgr_init(&rm, classes, instances, procs) == -1) {
+        fprintf(stderr, "resbench: bad sizes or out of memory\n");
+        return 1;
+    }
+    for (int p = 0; p < procs; p++) {
+        int r = rand_r(&seed) % classes;
+        resmgr_request(&rm, p, r, 1 + rand_r(&seed) % 2);
+        if (p % 2 == 0 && !(rm.waiting[p / 64] & (1ULL << (p % 64)))) {
+            resmgr_request(&rm, p, rand_r(&seed) % classes, 1 + rand_r(&seed) % 3);
+        }
+    }
+    time_detect("random", &rm, runs);
+    resmgr_free(&rm);
+
+    // Chain: the processes of each class (p % classes) hold one instance
+    // and wait for more the lower their index, so within a class only the
+    // highest waiter fits, then the next one down, one per sweep
+    int per = (procs + classes - 1) / classes;
+    if (resmgr_init(&rm, classes, per, procs) == -1) return 1;
+    for (int p = 0; p < procs; p++) resmgr_request(&rm, p, p % classes, 1);
+    for (int p = classes; p < procs; p++) {
+        int members = (procs - p % classes + classes - 1) / classes;
+        resmgr_request(&rm, p, p % classes, members - p / classes);
+    }
+    time_detect("chain", &rm, runs);
+    resmgr_free(&rm);
+
+    // Cycle: every instance is held, process p holding one of class
+    // p % ring, and every process waits for one of the next class, so
+    // class r waits on r + 1 all the way round and nobody can finish.
+    // (With fewer processes than classes the ring is that short.)
+    int ring = classes < procs ? classes : procs;
+    if (resmgr_init(&rm, classes, procs / ring, procs) == -1) return 1;
+    for (int p = 0; p < procs; p++) resmgr_request(&rm, p, p % ring, 1);
+    for (int p = 0; p < procs; p++) {
+        if (!(rm.waiting[p / 64] & (1ULL << (p % 64)))) resmgr_request(&rm, p, (p + 1) % ring, 1);
+    }
+    time_detect("cycle", &rm, runs);
+    resmgr_free(&rm);
+    return 0;
+}
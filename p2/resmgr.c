@@ -0,0 +1,219 @@
+// resmgr.c
+
+#include "resmgr.h"
+#include "clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BIT(p)  (1ULL << ((p) & 63))
+#define WORD(p) ((p) >> 6)
+
+// Bitset of the processes asking for at least k (1..instances) of class r
+static unsigned long long *req_row(const struct ResourceManager *rm, int r, int k) {
+    return rm->req_ge + ((size_t)r * (size_t)rm->instances + (size_t)(k - 1)) * (size_t)rm->words;
+}
+
+static unsigned short *cell(unsigned short *m, const struct ResourceManager *rm, int r, int p) {
+    return &m[(size_t)r * (size_t)rm->procs + (size_t)p];
+}
+
+// Add p's holdings to (sign 1) or take them out of (-1) the waiters' sum
+static void count_waiter(struct ResourceManager *rm, int p, int sign) {
+    for (unsigned long long cls = rm->held[p]; cls; cls &= cls - 1) {
+        int r = __builtin_ctzll(cls);
+        rm->waiter_alloc[r] += sign * *cell(rm->alloc, rm, r, p);
+    }
+}
+
+// Give p n more instances of r out of what is available
+static void grant(struct ResourceManager *rm, int p, int r, int n) {
+    unsigned short *held = cell(rm->alloc, rm, r, p);
+    rm->available[r] -= n;
+    *held = (unsigned short)(*held + n);
+    rm->held[p] |= 1ULL << r;
+}
+
+// Change p's outstanding request for r to 'count', keeping the rows in step
+static void set_request(struct ResourceManager *rm, int p, int r, int count) {
+    unsigned short *req = cell(rm->request, rm, r, p);
+    for (int k = *req + 1; k <= count; k++) req_row(rm, r, k)[WORD(p)] |= BIT(p);
+    for (int k = count + 1; k <= *req; k++) req_row(rm, r, k)[WORD(p)] &= ~BIT(p);
+    *req = (unsigned short)count;
+}
+
+int resmgr_init(struct ResourceManager *rm, int classes, int instances, int procs) {
+    memset(rm, 0, sizeof(*rm));
+    if (classes < 1 || classes > RES_MAX_CLASSES || instances < 1 || instances > RES_MAX_INSTANCES || procs < 1) {
+        return -1;
+    }
+    rm->classes   = classes;
+    rm->instances = instances;
+    rm->procs     = procs;
+    rm->words     = (procs + 63) / 64;
+    size_t cells  = (size_t)classes * (size_t)procs;
+    rm->alloc     = calloc(cells, sizeof(*rm->alloc));
+    rm->held      = calloc((size_t)procs, sizeof(*rm->held));
+    rm->request   = calloc(cells, sizeof(*rm->request));
+    rm->req_ge    = calloc((size_t)classes * (size_t)instances * (size_t)rm->words, sizeof(*rm->req_ge));
+    rm->waiting   = calloc((size_t)rm->words, sizeof(*rm->waiting));
+    rm->wanted    = calloc((size_t)rm->words, sizeof(*rm->wanted));
+    if (!rm->alloc || !rm->held || !rm->request || !rm->req_ge || !rm->waiting || !rm->wanted) {
+        resmgr_free(rm);
+        return -1;
+    }
+    for (int r = 0; r < classes; r++) rm->available[r] = instances;
+    return 0;
+}
+
+void resmgr_free(struct ResourceManager *rm) {
+    free(rm->alloc);
+    free(rm->held);
+    free(rm->request);
+    free(rm->req_ge);
+    free(rm->waiting);
+    free(rm->wanted);
+    rm->alloc  = rm->request = NULL;
+    rm->held   = rm->req_ge = rm->waiting = rm->wanted = NULL;
+}
+
+int resmgr_request(struct ResourceManager *rm, int proc, int r, int n) {
+    if (r < 0 || r >= rm->classes || n <= 0) return 1;
+    rm->stats.requests++;
+    unsigned short *held = cell(rm->alloc, rm, r, proc);
+    if (n > rm->instances - *held) n = rm->instances - *held;  // never more than exists
+    if (n <= rm->available[r]) {
+        grant(rm, proc, r, n);
+        rm->stats.immediate++;
+        return 1;
+    }
+    set_request(rm, proc, r, *cell(rm->request, rm, r, proc) + n);
+    if (!(rm->waiting[WORD(proc)] & BIT(proc))) {
+        rm->waiting[WORD(proc)] |= BIT(proc);
+        count_waiter(rm, proc, 1);
+    }
+    rm->stats.queued++;
+    return 0;
+}
+
+void resmgr_release(struct ResourceManager *rm, int proc, int r, int n) {
+    if (r < 0 || r >= rm->classes || n <= 0) return;
+    unsigned short *held = cell(rm->alloc, rm, r, proc);
+    if (n > *held) n = *held;
+    *held = (unsigned short)(*held - n);
+    if (*held == 0) rm->held[proc] &= ~(1ULL << r);
+    if (rm->waiting[WORD(proc)] & BIT(proc)) rm->waiter_alloc[r] -= n;
+    rm->available[r] += n;
+    rm->stats.releases++;
+}
+
+void resmgr_release_all(struct ResourceManager *rm, int proc) {
+    if (rm->waiting[WORD(proc)] & BIT(proc)) {
+        count_waiter(rm, proc, -1);
+        for (int r = 0; r < rm->classes; r++) {
+            if (*cell(rm->request, rm, r, proc)) set_request(rm, proc, r, 0);
+        }
+        rm->waiting[WORD(proc)] &= ~BIT(proc);
+    }
+    for (unsigned long long cls = rm->held[proc]; cls; cls &= cls - 1) {
+        int r                = __builtin_ctzll(cls);
+        unsigned short *held = cell(rm->alloc, rm, r, proc);
+        rm->available[r] += *held;
+        *held = 0;
+    }
+    rm->held[proc] = 0;
+}
+
+int resmgr_grant_waiting(struct ResourceManager *rm, int *granted) {
+    int count = 0;
+    for (int w = 0; w < rm->words; w++) {
+        for (unsigned long long bits = rm->waiting[w]; bits; bits &= bits - 1) {
+            int p    = w * 64 + __builtin_ctzll(bits);
+            int fits = 1;
+            for (int r = 0; r < rm->classes && fits; r++) {
+                fits = *cell(rm->request, rm, r, p) <= rm->available[r];
+            }
+            if (!fits) continue;
+            count_waiter(rm, p, -1);
+            for (int r = 0; r < rm->classes; r++) {
+                unsigned short *req = cell(rm->request, rm, r, p);
+                if (*req == 0) continue;
+                grant(rm, p, r, *req);
+                set_request(rm, p, r, 0);
+            }
+            rm->waiting[w] &= ~BIT(p);
+            granted[count++] = p;
+        }
+    }
+    return count;
+}
+
+int resmgr_detect(struct ResourceManager *rm, unsigned long long *deadlocked) {
+    long long t0 = monotonic_ns();
+    int words    = rm->words;
+
+    // A process that waits for nothing can run to completion and give back
+    // what it holds, so the pool starts as everything the waiters do not hold
+    int work[RES_MAX_CLASSES];
+    for (int r = 0; r < rm->classes; r++) work[r] = rm->instances - rm->waiter_alloc[r];
+    memcpy(deadlocked, rm->waiting, (size_t)words * sizeof(*deadlocked));
+    // Per word, the classes anyone in it waits for: the only rows to look at
+    unsigned long long *wanted = rm->wanted;
+    for (int w = 0; w < words; w++) {
+        wanted[w] = 0;
+        if (!deadlocked[w]) continue;
+        for (int r = 0; r < rm->classes; r++) {
+            if (req_row(rm, r, 1)[w] & deadlocked[w]) wanted[w] |= 1ULL << r;
+        }
+    }
+
+    // Let every waiter whose request fits in the pool finish, add back what
+    // it held, and repeat until nobody else fits
+    int progress = 1;
+    while (progress) {
+        progress = 0;
+        for (int w = 0; w < words; w++) {
+            if (!deadlocked[w]) continue;
+            unsigned long long blocked = 0;
+            for (unsigned long long cls = wanted[w]; cls; cls &= cls - 1) {
+                int r = __builtin_ctzll(cls);
+                if (work[r] < rm->instances) blocked |= req_row(rm, r, work[r] + 1)[w];
+            }
+            unsigned long long runnable = deadlocked[w] & ~blocked;
+            if (!runnable) continue;
+            deadlocked[w] &= ~runnable;
+            progress = 1;
+            for (; runnable; runnable &= runnable - 1) {
+                int p = w * 64 + __builtin_ctzll(runnable);
+                for (unsigned long long cls = rm->held[p]; cls; cls &= cls - 1) {
+                    int r = __builtin_ctzll(cls);
+                    work[r] += *cell(rm->alloc, rm, r, p);
+                }
+            }
+        }
+    }
+
+    int count = 0;
+    for (int w = 0; w < words; w++) count += __builtin_popcountll(deadlocked[w]);
+
+    long long spent = monotonic_ns() - t0;
+    rm->stats.detections++;
+    rm->stats.detect_total_ns += spent;
+    if (spent > rm->stats.detect_max_ns) rm->stats.detect_max_ns = spent;
+    if (count > 0) rm->stats.deadlocks++;
+    return count;
+}
+
+int resmgr_has_waiting(const struct ResourceManager *rm) {
+    for (int w = 0; w < rm->words; w++) {
+        if (rm->waiting[w]) return 1;
+    }
+    return 0;
+}
+
+int resmgr_held(const struct ResourceManager *rm, int proc) {
+    int held = 0;
+    for (unsigned long long cls = rm->held[proc]; cls; cls &= cls - 1) {
+        held += rm->alloc[(size_t)__builtin_ctzll(cls) * (size_t)rm->procs + (size_t)proc];
+    }
+    return held;
+}
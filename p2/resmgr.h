@@ -0,0 +1,88 @@
+// resmgr.h
+
+#ifndef RESMGR_H
+#define RESMGR_H
+
+/*
+ * Resource manager for oss -R. There are R classes of resources with the
+ * same number of instances each. Workers ask for instances of one class
+ * (or give them back) in their dispatch replies. A request that fits in
+ * what is available is granted on the spot; otherwise the worker blocks
+ * until a release makes room. Nothing prevents deadlock, so oss runs
+ * resmgr_detect() periodically and terminates workers until the rest can
+ * finish.
+ *
+ * The matrices are laid out for the detection pass. Allocation and
+ * outstanding requests are structure-of-arrays, one row of counts per
+ * class. Requests are also kept as threshold bitsets: for every class r
+ * and count k there is a bitset of the processes asking for at least k
+ * instances of r. "Who cannot be satisfied with work[r] instances" is
+ * then the single row k = work[r] + 1. A detection pass ORs one row per
+ * class, 64 processes per word operation, and never compares counts.
+ * What the waiters hold is kept summed per class, and each process has a
+ * mask of the classes it holds, so neither the starting pool nor the
+ * instances a finished process hands back cost a pass over every class.
+ */
+
+#define RES_MAX_CLASSES   64
+#define RES_MAX_INSTANCES 64
+
+// Set by oss -R ("classes:instances"); workers then request and release
+#define RES_ENV "OSS_RESOURCES"
+
+struct ResourceStats {
+  unsigned long long requests;     // requests made
+  unsigned long long immediate;    // granted when made
+  unsigned long long queued;       // had to wait
+  unsigned long long releases;     // explicit releases
+  unsigned long long detections;   // resmgr_detect() calls
+  unsigned long long deadlocks;    // detections that found one
+  unsigned long long victims;      // processes terminated to break them
+  long long detect_total_ns;       // real time spent detecting
+  long long detect_max_ns;
+};
+
+struct ResourceManager {
+  int classes;
+  int instances;                      // per class
+  int procs;                          // process slots
+  int words;                          // 64-bit words per process bitset
+  int available[RES_MAX_CLASSES];
+  int waiter_alloc[RES_MAX_CLASSES];  // instances held by processes that wait
+  unsigned short *alloc;              // [class * procs + proc] instances held
+  unsigned long long *held;           // [proc] bitmask of the classes it holds any of
+  unsigned short *request;            // [class * procs + proc] instances waited for
+  unsigned long long *req_ge;         // [(class * instances + k - 1) * words]: request >= k
+  unsigned long long *waiting;        // [words] processes with an outstanding request
+  unsigned long long *wanted;         // [words] resmgr_detect() scratch: classes waited for per word
+  struct ResourceStats stats;
+};
+
+// Allocate the matrices, everything available; -1 on bad sizes or no memory
+int resmgr_init( struct ResourceManager *rm, int classes, int instances, int procs );
+void resmgr_free( struct ResourceManager *rm );
+
+// Ask for n instances of class r; 1 if granted now, 0 if the process now waits
+int resmgr_request( struct ResourceManager *rm, int proc, int r, int n );
+
+// Give back n instances of class r
+void resmgr_release( struct ResourceManager *rm, int proc, int r, int n );
+
+// Drop everything the process holds or waits for (it exited or was killed)
+void resmgr_release_all( struct ResourceManager *rm, int proc );
+
+// Grant outstanding requests that now fit, in slot order. Writes the slots
+// granted to 'granted' (room for procs entries) and returns how many.
+int resmgr_grant_waiting( struct ResourceManager *rm, int *granted );
+
+// Deadlock detection. Sets the bits of the deadlocked processes in
+// 'deadlocked' (words entries) and returns how many there are.
+int resmgr_detect( struct ResourceManager *rm, unsigned long long *deadlocked );
+
+// 1 if any process waits for a grant
+int resmgr_has_waiting( const struct ResourceManager *rm );
+
+// Instances the process holds, over all classes
+int resmgr_held( const struct ResourceManager *rm, int proc );
+
+#endif /* RESMGR_H */
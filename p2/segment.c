@@ -0,0 +1,198 @@
+// segment.c
+
+#define _GNU_SOURCE
+#include "segment.h"
+#include "shared.h"
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/shm.h>
+#include <unistd.h>
+
+// Read the state letter and starttime (field 22) from /proc/<pid>/stat.
+// Returns 0 if the process does not exist or the file cannot be parsed.
+static int read_proc_stat(pid_t pid, char *state, unsigned long long *start) {
+    char path[64];
+    char buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+
+    // comm may contain spaces and ')' so skip to the last ')'; the state is
+    // the next field and starttime is the 20th field after the state.
+    char *p = strrchr(buf, ')');
+    if (!p || p[1] != ' ' || p[2] == '\0') return 0;
+    *state = p[2];
+    p += 2;
+    for (int field = 0; field < 19 && p; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    if (!p) return 0;
+    *start = strtoull(p + 1, NULL, 10);
+    return 1;
+}
+
+unsigned long long process_start_time(pid_t pid) {
+    char state;
+    unsigned long long start = 0;
+    return read_proc_stat(pid, &state, &start) ? start : 0;
+}
+
+int owner_is_alive(pid_t pid, unsigned long long start) {
+    if (pid <= 0) return 0;
+    if (kill(pid, 0) == -1 && errno == ESRCH) return 0;
+
+    // The PID exists; a zombie (killed but not yet reaped) is as good as
+    // dead, and a different start time means the PID was recycled.
+    char state;
+    unsigned long long now_start;
+    if (!read_proc_stat(pid, &state, &now_start)) return 1;
+    if (state == 'Z' || state == 'X') return 0;
+    return now_start == start;
+}
+
+// Open the segment a previous run left behind. One of a different size was
+// created by a build with a different layout (shmget only rejects segments
+// smaller than we ask for, so check the size ourselves): remove it if its
+// creator is gone and create a fresh one, otherwise refuse to touch it.
+static int open_existing_segment(void) {
+    int id = shmget(SHM_KEY, 0, 0);
+    if (id == -1) return -1;
+
+    struct shmid_ds ds;
+    if (shmctl(id, IPC_STAT, &ds) == -1) return -1;
+    if (ds.shm_segsz == sizeof(struct SharedSegment)) return id;
+
+    if (kill(ds.shm_cpid, 0) == 0 || errno != ESRCH) {
+        fprintf(stderr, "OSS: segment 0x%x is %zu bytes, expected %zu, and its creator (pid %d) is alive\n",
+                SHM_KEY, (size_t)ds.shm_segsz, sizeof(struct SharedSegment), (int)ds.shm_cpid);
+        exit(EXIT_FAILURE);
+    }
+    printf("OSS: removing stale segment with a different layout (creator pid %d)\n", (int)ds.shm_cpid);
+    if (shmctl(id, IPC_RMID, NULL) == -1) return -1;
+    return shmget(SHM_KEY, sizeof(struct SharedSegment), IPC_CREAT | IPC_EXCL | 0666);
+}
+
+static void refuse_segment(struct SharedSegment *seg, const char *why, pid_t owner) {
+    fprintf(stderr, "OSS: %s (pid %d)\n", why, (int)owner);
+    shmdt(seg);
+    exit(EXIT_FAILURE);
+}
+
+struct SharedSegment *claim_shared_segment(int *shmid_out) {
+    // Try to create the segment exclusively first; only if it already exists
+    // do we attach to someone else's and check its size.
+    int id = shmget(SHM_KEY, sizeof(struct SharedSegment), IPC_CREAT | IPC_EXCL | 0666);
+    if (id == -1 && errno == EEXIST) {
+        id = open_existing_segment();
+    }
+    if (id == -1) {
+        handle_error("shmget claim");
+    }
+
+    // Attach without the named semaphore: if the previous owner died inside
+    // attach/detach, the semaphore is stuck at zero and must not be waited on.
+    struct SharedSegment *seg = (struct SharedSegment *)shmat(id, NULL, 0);
+    if (seg == (void *)-1) {
+        handle_error("shmat claim");
+    }
+
+    struct SegmentHeader *hdr = &seg->header;
+    unsigned long long generation = 0;
+    pid_t previous = __atomic_load_n(&hdr->owner_pid, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) == SEGMENT_MAGIC) {
+        if (owner_is_alive(previous, hdr->owner_start)) {
+            refuse_segment(seg, "shared segment is owned by a running oss", previous);
+        }
+        if (hdr->size != sizeof(*seg)) {
+            refuse_segment(seg, "shared segment header has a different layout; remove it with ipcrm", previous);
+        }
+        generation = hdr->generation;
+    } else if (previous != 0 && owner_is_alive(previous, process_start_time(previous))) {
+        // No magic yet: the owner is still initializing and has not written
+        // its start time, so only ask whether the PID is a live process
+        refuse_segment(seg, "shared segment is being initialized by another oss", previous);
+    }
+
+    // Take ownership before touching anything else. Of two oss processes
+    // that got this far, only one swaps owner_pid away from what both saw.
+    pid_t self = getpid();
+    if (!__atomic_compare_exchange_n(&hdr->owner_pid, &previous, self, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        refuse_segment(seg, "another oss claimed the shared segment first", previous);
+    }
+    if (previous != 0) {
+        printf("OSS: reclaiming segment from dead oss pid %d (generation %llu)\n", (int)previous, generation);
+        reset_shared_memory_system();
+    }
+
+    // Reinitialize in place, leaving owner_pid alone so a late competitor
+    // still finds it taken. The generation is published last so workers
+    // left over from the dead run notice the change and exit.
+    __atomic_store_n(&hdr->magic, 0u, __ATOMIC_RELEASE);
+    size_t body = offsetof(struct SharedSegment, clock);
+    memset((char *)seg + body, 0, sizeof(*seg) - body);
+    initialize_clock(&seg->clock);
+    hdr->size        = (unsigned int)sizeof(*seg);
+    hdr->owner_start = process_start_time(self);
+    __atomic_store_n(&hdr->generation, generation + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&hdr->magic, SEGMENT_MAGIC, __ATOMIC_RELEASE);
+
+    *shmid_out = id;
+    return seg;
+}
+
+void release_shared_segment(struct SharedSegment *seg) {
+    if (seg) {
+        __atomic_store_n(&seg->header.owner_pid, 0, __ATOMIC_RELEASE);
+    }
+}
+
+const struct SysClock *segment_local_clock(const struct SharedSegment *seg) {
+    int count = __atomic_load_n(&seg->replicas.count, __ATOMIC_ACQUIRE);
+    if (count == 0) return &seg->clock;
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= CLOCK_REPLICA_CPUS || seg->replicas.of_cpu[cpu] >= count) return &seg->clock;
+    return &seg->replicas.lines[seg->replicas.of_cpu[cpu]].clock;
+}
+
+void segment_read_clock(const struct SharedSegment *seg, const struct SysClock *clock, int *sec, int *nano) {
+    if (__atomic_load_n(&seg->clock_page.active, __ATOMIC_ACQUIRE)) {
+        long long now_ns = clock_page_read(&seg->clock_page, monotonic_ns());
+        *sec  = (int)(now_ns / 1000000000LL);
+        *nano = (int)(now_ns % 1000000000LL);
+    } else {
+        read_clock(clock, sec, nano);
+    }
+}
+
+unsigned long long segment_generation(const struct SharedSegment *seg) {
+    return __atomic_load_n(&seg->header.generation, __ATOMIC_ACQUIRE);
+}
+
+void seqlock_write_begin(unsigned int *seq) {
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void seqlock_write_end(unsigned int *seq) {
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+int seqlock_read(const void *src, void *dst, size_t len, int tries) {
+    const unsigned int *seq = (const unsigned int *)src;
+    while (tries-- > 0) {
+        unsigned int before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        if (before & 1u) continue;
+        memcpy(dst, src, len);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(seq, __ATOMIC_RELAXED) == before) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+// segment.h
+
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "clock.h"
+#include "perfctr.h"
+
+/*
+ * Layout of the SysV segment shared by oss and its workers. The header
+ * records which oss owns the segment, so that a new oss can tell a live
+ * owner apart from one that crashed and leaked the segment (and the
+ * named semaphore), and reinitialize it in place instead of needing
+ * clean.sh between runs.
+ */
+
+#define SEGMENT_MAGIC 0x4f535332u  // "OSS2"
+
+// Size of the process table; every slot has its own blocks in the segment
+#ifndef MAX_PROCESSES
+#define MAX_PROCESSES 20
+#endif
+
+struct SegmentHeader {
+  unsigned int magic;              // SEGMENT_MAGIC once the owner finished initializing
+  unsigned int size;               // sizeof(struct SharedSegment) as seen by the owner
+  pid_t owner_pid;                 // oss that owns the segment, 0 after a clean exit
+  unsigned long long owner_start;  // owner's start time (clock ticks since boot)
+  unsigned long long generation;   // bumped every time an oss (re)initializes the segment
+};
+
+// Lifecycle of a PCB slot as oss sees it
+enum PcbState {
+  PCB_EMPTY = 0,  // slot free
+  PCB_RUNNING,    // worker launched and not yet reaped (with -m: dispatched)
+  PCB_STOPPING,   // terminate posted, waiting for the worker to exit
+  PCB_READY,      // -m: waiting on a ready queue
+  PCB_BLOCKED,    // -m: waiting for its wakeup event
+  PCB_SPAWNING    // -M: slot reserved, the spawner thread has not forked yet
+};
+
+/*
+ * Per-worker telemetry, one cache line per PCB slot. Only the worker in
+ * that slot writes it (plain stores, no atomics); oss reads the blocks
+ * lazily when printing the table and when it reaps the worker.
+ */
+struct WorkerCounters {
+  _Alignas( 64 ) unsigned long long clock_reads;  // SysClock samples taken
+  unsigned long long loop_iterations;             // passes through the poll loop
+  long long overshoot_ns;                         // sim ns past end time when it noticed
+  long long spawn_real_ns;                        // oss: monotonic time just before fork
+  long long attach_real_ns;                       // worker: monotonic time once attached
+  long long exit_real_ns;                         // worker: monotonic time on its way out
+  pid_t pid;                                      // worker owning the block
+  int done;                                       // 1 once overshoot_ns is final
+  unsigned int ack_seq;                           // last channel seq the worker acted on
+};
+
+// Commands oss can post to a worker's channel (see doorbell.h)
+enum WorkerCommand {
+  CMD_NONE = 0,
+  CMD_TERMINATE,  // print a final report and exit now
+  CMD_REPORT,     // print a status line and keep running
+  CMD_DISPATCH    // -m: run for up to 'quantum_ns' sim ns, then reply
+};
+
+// oss -> worker command slot, one cache line per PCB slot. oss sets bits
+// in 'pending' and bumps 'seq'; the worker clears each bit as it takes
+// the command and sets 'parked' while it sleeps on 'seq'.
+struct WorkerChannel {
+  _Alignas( 64 ) unsigned int seq;  // futex word, bumped after every post
+  unsigned int pending;             // 1u << command for each command posted and not yet taken
+  long long quantum_ns;             // CMD_DISPATCH argument, written before its bit is set
+  unsigned int parked;              // worker is in futex_wait on seq; wake it after posting
+};
+
+// How a dispatched worker gave the CPU back
+enum DispatchOutcome {
+  DISPATCH_PREEMPTED = 1,  // used the whole quantum
+  DISPATCH_BLOCKED,        // blocked after used_ns for block_ns
+  DISPATCH_EXITED,         // finished after used_ns
+  DISPATCH_REQUEST,        // -R: wants 'count' instances of 'resource' before it goes on
+  DISPATCH_RELEASE,        // -R: gave back 'count' instances of 'resource', still runnable
+  DISPATCH_MEMORY,         // -P: referenced 'address' (a write if 'write'), goes on once it is in memory
+  DISPATCH_IO              // -I: blocked on a request for 'cylinder' of 'device' until it completes
+};
+
+// worker -> oss reply to CMD_DISPATCH, one cache line per PCB slot
+struct WorkerReply {
+  _Alignas( 64 ) unsigned int seq;  // bumped (release) once the fields below are written
+  int outcome;                      // enum DispatchOutcome
+  long long used_ns;                // sim ns of the quantum used
+  long long block_ns;               // DISPATCH_BLOCKED: sim ns until it is ready again
+  int resource;                     // DISPATCH_REQUEST/RELEASE: resource class
+  int count;                        // DISPATCH_REQUEST/RELEASE: instances
+  unsigned int address;             // DISPATCH_MEMORY: virtual address referenced
+  int write;                        // DISPATCH_MEMORY: 1 for a store
+  int device;                       // DISPATCH_IO: which device
+  int cylinder;                     // DISPATCH_IO: where on it
+  unsigned int oss_parked;          // oss is in futex_wait on seq; wake it after replying
+};
+
+/*
+ * Read-only views published by oss for monitoring tools (osstop). Each
+ * is guarded by its own sequence counter: oss makes it odd while
+ * writing, readers copy the data and retry if the counter was odd or
+ * moved, so tools never take a lock or slow oss down.
+ */
+struct OssStatus {
+  unsigned int seq;
+  int simul;                  // -s
+  int num_workers;            // -n
+  int active;                 // occupied PCB slots, or live tasks under -L
+  int launched;               // workers launched so far
+  int task_threads;           // -L pool threads (0: workers are processes and have PCBs)
+  long long increment;        // current_increment (sim ns per tick)
+  double ratio;               // sim/real ratio at the last feedback check
+  long long real_elapsed_ns;  // real time since oss started, at the last update
+};
+
+struct PcbView {
+  unsigned int seq;
+  int state;  // enum PcbState
+  pid_t pid;
+  int startSec;
+  int startNano;
+  int cpu;  // -1 if unpinned
+};
+
+/*
+ * oss -C: replicas of the clock, one per NUMA node or LLC domain. oss
+ * copies the clock into every line after a tick (at most every
+ * granularity_ns of sim time, and whenever parked workers were woken so
+ * they do not wake to a stale copy) and each worker reads the line for
+ * the CPU it runs on, so the readers of one line share a cache. With
+ * count == 0 everyone reads 'clock'.
+ */
+#define CLOCK_MAX_REPLICAS 16
+#define CLOCK_REPLICA_CPUS 1024
+
+struct ClockReplicaSet {
+  int count;                                   // replicas in use
+  long long granularity_ns;                    // sim time between copies, 0 = every tick
+  unsigned char of_cpu[CLOCK_REPLICA_CPUS];    // replica for each CPU
+  struct ClockReplica lines[CLOCK_MAX_REPLICAS];
+};
+
+struct SharedSegment {
+  struct SegmentHeader header;                 // written only when oss claims or releases the segment
+  _Alignas( 64 ) struct SysClock clock;        // written by oss every tick, so alone on its line
+  _Alignas( 64 ) struct ClockPage clock_page;  // oss -V; read-mostly, so off the clock's line
+  _Alignas( 64 ) unsigned int doorbell;  // bumped whenever any channel changes
+  _Alignas( 64 ) struct ClockReplicaSet replicas;  // read-mostly, so off the doorbell's line
+  struct WorkerCounters counters[MAX_PROCESSES];
+  struct WorkerChannel channels[MAX_PROCESSES];
+  struct WorkerReply replies[MAX_PROCESSES];
+  _Alignas( 64 ) struct OssStatus status;
+  struct PcbView pcbs[MAX_PROCESSES];
+  struct PerfSample perf[MAX_PROCESSES];  // written once by a worker at exit (oss -e)
+};
+
+// Workers poll the header, the clock page and the replicas; none of them
+// may share a line with the clock oss writes every tick
+_Static_assert( offsetof( struct SharedSegment, clock ) % 64 == 0 &&
+                    offsetof( struct SharedSegment, clock ) >= sizeof( struct SegmentHeader ),
+                "the clock must start its own cache line" );
+_Static_assert( offsetof( struct SharedSegment, clock_page ) >=
+                    offsetof( struct SharedSegment, clock ) + 64,
+                "the clock page must not share the clock's line" );
+
+// Create the segment, or reclaim it from a dead owner, and return it
+// attached read/write with a fresh header. Exits if a live oss owns it,
+// another oss wins the race to claim it, or its size is not ours.
+struct SharedSegment *claim_shared_segment( int *shmid_out );
+
+// Mark the segment as no longer owned (called by oss on a clean exit)
+void release_shared_segment( struct SharedSegment *seg );
+
+// The clock a worker on this CPU should read: its replica (oss -C) or the clock itself
+const struct SysClock *segment_local_clock( const struct SharedSegment *seg );
+
+// The sim time as a worker sees it: worked out from the clock page under
+// oss -V, otherwise read from 'clock' (the segment's clock or a replica)
+void segment_read_clock( const struct SharedSegment *seg, const struct SysClock *clock, int *sec, int *nano );
+
+// Current generation of the segment (acquire load, safe to poll)
+unsigned long long segment_generation( const struct SharedSegment *seg );
+
+// Seqlock writer side: make *seq odd before updating, even again after
+void seqlock_write_begin( unsigned int *seq );
+void seqlock_write_end( unsigned int *seq );
+
+// Seqlock reader side: copy 'len' bytes of 'src' into 'dst' consistently
+// ('src' starts with the sequence word). Gives up after 'tries' attempts
+// and returns 0; returns 1 on success.
+int seqlock_read( const void *src, void *dst, size_t len, int tries );
+
+// Short name of an enum PcbState value
+static inline const char *pcb_state_name( int state ) {
+  static const char *names[PCB_SPAWNING + 1] = { "empty", "running", "stopping", "ready", "blocked", "spawning" };
+  return state >= PCB_EMPTY && state <= PCB_SPAWNING ? names[state] : "?";
+}
+
+// Start time of a process in clock ticks since boot, or 0 if unknown
+unsigned long long process_start_time( pid_t pid );
+
+// 1 if 'pid' is alive and is still the process that started at 'start'
+int owner_is_alive( pid_t pid, unsigned long long start );
+
+#endif /* SEGMENT_H */
@@ -1,12 +1,16 @@
 #include "shared.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
 #include <semaphore.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/shm.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 static sem_t *shm_semaphore = NULL;
@@ -47,6 +51,12 @@ void cleanup_shared_memory_system(void) {
     }
 }
 
+void reset_shared_memory_system(void) {
+    if (sem_unlink(SEM_NAME) == -1 && errno != ENOENT) {
+        perror("sem_unlink stale");
+    }
+}
+
 int create_shared_memory(key_t key, size_t size) {
     int shmid = shmget(key, size, IPC_CREAT | 0666);
     if (shmid == -1) {
@@ -56,6 +66,14 @@ int create_shared_memory(key_t key, size_t size) {
     return shmid;
 }
 
+int open_shared_memory(key_t key, size_t size) {
+    int shmid = shmget(key, size, 0);
+    if (shmid == -1 && errno != ENOENT) {
+        perror("shmget open");
+    }
+    return shmid;
+}
+
 void *attach_shared_memory_rw(int shmid) {
     if (sem_wait(shm_semaphore) == -1) {
         perror("sem_wait attach RW");
@@ -74,24 +92,6 @@ void *attach_shared_memory_rw(int shmid) {
     return addr;
 }
 
-const void *attach_shared_memory_ro(int shmid) {
-    if (sem_wait(shm_semaphore) == -1) {
-        perror("sem_wait attach RO");
-        exit(EXIT_FAILURE);
-    }
-    const void *addr = shmat(shmid, NULL, SHM_RDONLY);
-    if (addr == (void *)-1) {
-        perror("shmat RO");
-        sem_post(shm_semaphore);
-        exit(EXIT_FAILURE);
-    }
-    if (sem_post(shm_semaphore) == -1) {
-        perror("sem_post attach RO");
-        exit(EXIT_FAILURE);
-    }
-    return addr;
-}
-
 void detach_shared_memory(void *addr) {
     if (sem_wait(shm_semaphore) == -1) {
         perror("sem_wait detach");
@@ -114,6 +114,23 @@ void cleanup_shared_memory(int shmid) {
     }
 }
 
+void futex_wake(unsigned int *word, int count) {
+    // The segment is shared between processes, so no FUTEX_PRIVATE_FLAG
+    syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+void futex_wait(const unsigned int *word, unsigned int expected, long long timeout_ns) {
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+    if (timeout_ns > 0) {
+        ts.tv_sec  = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        tsp        = &ts;
+    }
+    // EAGAIN (value already changed), EINTR and ETIMEDOUT all just return
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, tsp, NULL, 0);
+}
+
 void setup_signal_handlers(void) {
     struct sigaction sa;
     memset(&sa, 0, sizeof(sa));
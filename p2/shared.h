@@ -12,21 +12,30 @@ void init_shared_memory_system( void );
 // Cleanup the shared memory system (closes/unlinks the named semaphore)
 void cleanup_shared_memory_system( void );
 
+// Unlink a semaphore leaked by a crashed run so the next init starts fresh
+void reset_shared_memory_system( void );
+
 // Create a shared memory segment (returns shmid). Exits on error.
 int create_shared_memory( key_t key, size_t size );
 
+// Look up an existing segment without creating it (returns -1 if absent)
+int open_shared_memory( key_t key, size_t size );
+
 // Attach shared memory in read/write mode
 void *attach_shared_memory_rw( int shmid );
 
-// Attach shared memory in read-only mode (const pointer returned)
-const void *attach_shared_memory_ro( int shmid );
-
 // Detach from a shared memory segment
 void detach_shared_memory( void *addr );
 
 // Remove a shared memory segment from the system
 void cleanup_shared_memory( int shmid );
 
+// Wake up to 'count' processes blocked in futex_wait() on 'word' (shared, not private)
+void futex_wake( unsigned int *word, int count );
+
+// Block while *word == expected, for at most timeout_ns (<= 0 waits forever)
+void futex_wait( const unsigned int *word, unsigned int expected, long long timeout_ns );
+
 // Setup signal handlers (e.g., SIGINT)
 void setup_signal_handlers( void );
 
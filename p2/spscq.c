@@ -0,0 +1,65 @@
+// spscq.c
+
+#include "spscq.h"
+#include "shared.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int spsc_init(struct SpscQueue *q, unsigned int capacity, size_t size) {
+    memset(q, 0, sizeof(*q));
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return -1;
+    q->slots = calloc(capacity, size);
+    if (!q->slots) return -1;
+    q->capacity = capacity;
+    q->size     = size;
+    return 0;
+}
+
+void spsc_free(struct SpscQueue *q) {
+    free(q->slots);
+    q->slots = NULL;
+}
+
+int spsc_push(struct SpscQueue *q, const void *msg) {
+    unsigned int h = q->head;
+    if (h - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) >= q->capacity) return 0;
+    memcpy(q->slots + (size_t)(h & (q->capacity - 1)) * q->size, msg, q->size);
+    // seq_cst pairs with the consumer setting 'sleeping' and re-checking
+    // head, so a wakeup cannot be lost
+    __atomic_store_n(&q->head, h + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->sleeping, __ATOMIC_SEQ_CST)) spsc_kick(q);
+    return 1;
+}
+
+void spsc_push_wait(struct SpscQueue *q, const void *msg) {
+    const struct timespec backoff = { 0, SPSC_FULL_NS };
+    while (!spsc_push(q, msg)) {
+        nanosleep(&backoff, NULL);
+    }
+}
+
+int spsc_pop(struct SpscQueue *q, void *msg) {
+    unsigned int t = q->tail;
+    if (__atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == t) return 0;
+    memcpy(msg, q->slots + (size_t)(t & (q->capacity - 1)) * q->size, q->size);
+    __atomic_store_n(&q->tail, t + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void spsc_wait(struct SpscQueue *q, const int *stop, long long timeout_ns) {
+    // Snapshot the wake word first: a kick after this point changes it and
+    // the futex wait returns at once
+    unsigned int w = __atomic_load_n(&q->wake, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&q->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->head, __ATOMIC_SEQ_CST) == q->tail &&
+        !(stop && __atomic_load_n(stop, __ATOMIC_SEQ_CST))) {
+        futex_wait(&q->wake, w, timeout_ns);
+    }
+    __atomic_store_n(&q->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+void spsc_kick(struct SpscQueue *q) {
+    __atomic_add_fetch(&q->wake, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&q->wake, 1);
+}
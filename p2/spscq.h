@@ -0,0 +1,52 @@
+// spscq.h
+
+#ifndef SPSCQ_H
+#define SPSCQ_H
+
+#include <stddef.h>
+
+#define SPSC_FULL_NS 100000LL  // spsc_push_wait back-off (real)
+
+/*
+ * Bounded single-producer / single-consumer queue of fixed-size
+ * messages, used between the oss threads. Each side owns one index on
+ * its own cache line, so a push or a pop is a memcpy plus one release
+ * store and neither side ever takes a lock. A consumer with nothing to
+ * do can sleep in spsc_wait(); the producer only pays for a FUTEX_WAKE
+ * when the consumer is actually asleep.
+ */
+
+struct SpscQueue {
+  unsigned int capacity;  // power of two
+  size_t size;            // bytes per message
+  unsigned char *slots;
+
+  _Alignas( 64 ) unsigned int head;  // next message the producer fills
+  unsigned int wake;                 // futex word, bumped to wake the consumer
+  unsigned int sleeping;             // consumer is in (or entering) spsc_wait
+
+  _Alignas( 64 ) unsigned int tail;  // next message the consumer takes
+};
+
+// Allocate room for 'capacity' (a power of two) messages of 'size' bytes
+int spsc_init( struct SpscQueue *q, unsigned int capacity, size_t size );
+void spsc_free( struct SpscQueue *q );
+
+// Producer: copy 'msg' in; 0 if the queue is full
+int spsc_push( struct SpscQueue *q, const void *msg );
+
+// Producer: like spsc_push, but sleep SPSC_FULL_NS at a time until there is room.
+// Sleeping, not spinning or yielding, leaves the CPU to the consumer it waits for.
+void spsc_push_wait( struct SpscQueue *q, const void *msg );
+
+// Consumer: copy the oldest message out; 0 if the queue is empty
+int spsc_pop( struct SpscQueue *q, void *msg );
+
+// Consumer: sleep until a message arrives, *stop becomes nonzero,
+// spsc_kick() is called or timeout_ns passes (<= 0 waits forever)
+void spsc_wait( struct SpscQueue *q, const int *stop, long long timeout_ns );
+
+// Wake the consumer whether or not anything was pushed (after setting *stop)
+void spsc_kick( struct SpscQueue *q );
+
+#endif /* SPSCQ_H */
@@ -0,0 +1,54 @@
+// stageprof.c
+
+#include "stageprof.h"
+
+#ifdef OSS_STAGE_PROFILE
+
+#include <stdio.h>
+
+__thread struct StageProfile stage_prof = { .current = -1 };
+
+static const char *stage_names[STAGE_COUNT] = {
+    "A timecheck", "B spin", "C tick", "D waitpid", "E spawn", "F print", "G donecheck", "H feedback",
+};
+
+void stage_prof_report(void) {
+    unsigned long long total = 0, total_syscalls = 0;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        total += stage_prof.cycles[s];
+        total_syscalls += stage_prof.syscalls[s];
+    }
+    if (total == 0 || stage_prof.iterations == 0) return;
+
+    double iters = (double)stage_prof.iterations;
+    fprintf(stderr, "OSS: stage profile over %llu iterations, %.1f cycles/iteration, %.3f syscalls/iteration\n",
+            stage_prof.iterations, (double)total / iters, (double)total_syscalls / iters);
+    fprintf(stderr, "  %-12s %6s %14s %12s %16s\n", "stage", "share", "cycles/entry", "hits", "syscalls/iter");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        unsigned long long entries = stage_prof.entries[s] ? stage_prof.entries[s] : 1;
+        fprintf(stderr, "  %-12s %5.1f%% %14.1f %12llu %16.4f\n", stage_names[s],
+                100.0 * (double)stage_prof.cycles[s] / (double)total,
+                (double)stage_prof.cycles[s] / (double)entries, stage_prof.hits[s],
+                (double)stage_prof.syscalls[s] / iters);
+    }
+
+    // One-line summary, biggest stages first
+    int order[STAGE_COUNT];
+    for (int s = 0; s < STAGE_COUNT; s++) order[s] = s;
+    for (int i = 1; i < STAGE_COUNT; i++) {
+        for (int j = i; j > 0 && stage_prof.cycles[order[j]] > stage_prof.cycles[order[j - 1]]; j--) {
+            int t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+    fprintf(stderr, "  summary:");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        double share = 100.0 * (double)stage_prof.cycles[order[i]] / (double)total;
+        if (share < 1.0) break;
+        fprintf(stderr, "%s %s %.0f%%", i ? "," : "", stage_names[order[i]], share);
+    }
+    fprintf(stderr, "\n");
+}
+
+#endif /* OSS_STAGE_PROFILE */
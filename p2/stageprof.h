@@ -0,0 +1,80 @@
+// stageprof.h
+
+#ifndef STAGEPROF_H
+#define STAGEPROF_H
+
+/*
+ * Optional profiler for the stages (A)-(H) of the oss main loop. Build
+ * with `make STAGE_PROFILE=1` (defines OSS_STAGE_PROFILE) to get, at
+ * exit, the share of loop cycles spent in each stage, how often each
+ * stage actually did work, and the syscalls issued per iteration.
+ *
+ * Cycles are charged lap-style: STAGE_ENTER(s) reads the TSC once and
+ * charges the time since the previous STAGE_ENTER to the stage that was
+ * running. The profile is per thread, so only the main loop's thread is
+ * reported (the oss -M helper threads count into their own copies).
+ * Without OSS_STAGE_PROFILE every macro expands to nothing.
+ */
+
+enum LoopStage {
+  STAGE_A_TIMECHECK = 0,  // (A) real-time limit
+  STAGE_B_SPIN,           // (B) spin
+  STAGE_C_TICK,           // (C) clock increment
+  STAGE_D_WAITPID,        // (D) reap finished workers
+  STAGE_E_SPAWN,          // (E) spawn
+  STAGE_F_PRINT,          // (F) table print and report broadcast
+  STAGE_G_DONECHECK,      // (G) all done?
+  STAGE_H_FEEDBACK,       // (H) increment feedback
+  STAGE_COUNT
+};
+
+#ifdef OSS_STAGE_PROFILE
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define stage_prof_cycles() ( (unsigned long long)__rdtsc() )
+#else
+#include "clock.h"
+#define stage_prof_cycles() ( (unsigned long long)monotonic_ns() )
+#endif
+
+struct StageProfile {
+  int current;                                 // stage being charged, -1 before the first one
+  unsigned long long lap;                      // stage_prof_cycles() at the last STAGE_ENTER
+  unsigned long long iterations;               // passes through the loop
+  unsigned long long cycles[STAGE_COUNT];      // charged to each stage
+  unsigned long long entries[STAGE_COUNT];     // STAGE_ENTER count
+  unsigned long long hits[STAGE_COUNT];        // times the stage did its work (STAGE_HIT)
+  unsigned long long syscalls[STAGE_COUNT];    // STAGE_SYSCALL count
+};
+
+extern __thread struct StageProfile stage_prof;
+
+static inline void stage_prof_enter( int stage ) {
+  unsigned long long now = stage_prof_cycles( );
+  if ( stage_prof.current >= 0 ) stage_prof.cycles[stage_prof.current] += now - stage_prof.lap;
+  stage_prof.lap = now;
+  stage_prof.current = stage;
+  stage_prof.entries[stage]++;
+  if ( stage == STAGE_A_TIMECHECK ) stage_prof.iterations++;
+}
+
+// Print the breakdown to stderr
+void stage_prof_report( void );
+
+#define STAGE_ENTER( s ) stage_prof_enter( s )
+#define STAGE_HIT( s ) ( stage_prof.hits[s]++ )
+#define STAGE_SYSCALL( ) \
+  ( stage_prof.syscalls[stage_prof.current >= 0 ? stage_prof.current : 0]++ )
+#define STAGE_REPORT( ) stage_prof_report( )
+
+#else
+
+#define STAGE_ENTER( s ) ( (void)0 )
+#define STAGE_HIT( s ) ( (void)0 )
+#define STAGE_SYSCALL( ) ( (void)0 )
+#define STAGE_REPORT( ) ( (void)0 )
+
+#endif /* OSS_STAGE_PROFILE */
+
+#endif /* STAGEPROF_H */
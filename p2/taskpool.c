@@ -0,0 +1,276 @@
+// taskpool.c
+
+#include "taskpool.h"
+#include "clock.h"
+#include "spscq.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SPAWN_SLOTS   4096
+#define EVENT_SLOTS   16384
+// A parked thread wakes this often (real) to pick up new tasks and 'stopping'
+#define TASK_IDLE_NS  1000000LL
+
+// oss -> pool thread
+struct TaskSpawn {
+  int id;
+  long long lifetime_ns;
+  long long spawn_real_ns;
+};
+
+struct Task {
+  int id;
+  int start_sec;
+  int last_reported_sec;
+  unsigned int reads;
+  long long end_ns;
+  long long next_ns;  // heap key: the next second boundary or the end
+  long long start_sim_ns;
+  long long spawn_real_ns;
+  long long start_real_ns;
+};
+
+struct PoolThread {
+  pthread_t thread;
+  struct SpscQueue spawns;
+  struct SpscQueue events;
+  int index;                 // in pool[], for TaskEvent.thread
+  struct Task *heap;
+  int count;
+  int capacity;
+  int done;                  // the thread has reported its last event
+  unsigned int report_seen;  // report_gen at the last report
+};
+
+static struct SharedSegment *seg;
+static struct PoolThread *pool;
+static int pool_size = 0;
+static taskpool_event_fn handle_event;
+static int stopping = 0;
+static unsigned int report_gen = 0;  // bumped by taskpool_report()
+
+// oss's side
+static int next_id     = 0;
+static int next_thread = 0;
+static int finished    = 0;
+
+static void heap_push(struct PoolThread *pt, const struct Task *task) {
+    if (pt->count == pt->capacity) {
+        int cap            = pt->capacity ? pt->capacity * 2 : 256;
+        struct Task *grown = realloc(pt->heap, (size_t)cap * sizeof(*grown));
+        if (!grown) {
+            perror("realloc task heap");
+            exit(1);
+        }
+        pt->heap     = grown;
+        pt->capacity = cap;
+    }
+    int i = pt->count++;
+    while (i > 0 && pt->heap[(i - 1) / 2].next_ns > task->next_ns) {
+        pt->heap[i] = pt->heap[(i - 1) / 2];
+        i           = (i - 1) / 2;
+    }
+    pt->heap[i] = *task;
+}
+
+static struct Task heap_pop(struct PoolThread *pt) {
+    struct Task top  = pt->heap[0];
+    struct Task last = pt->heap[--pt->count];
+    int i            = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= pt->count) break;
+        if (child + 1 < pt->count && pt->heap[child + 1].next_ns < pt->heap[child].next_ns) child++;
+        if (pt->heap[child].next_ns >= last.next_ns) break;
+        pt->heap[i] = pt->heap[child];
+        i           = child;
+    }
+    if (pt->count > 0) pt->heap[i] = last;
+    return top;
+}
+
+static void emit(struct PoolThread *pt, const struct Task *task, int type, long long sim_ns, const long long *args,
+                 int argc) {
+    struct TaskEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type          = type;
+    ev.id            = task->id;
+    ev.thread        = pt->index;
+    ev.sim_ns        = sim_ns;
+    ev.real_ns       = monotonic_ns();
+    ev.argc          = argc;
+    ev.reads         = task->reads;
+    ev.start_sim_ns  = task->start_sim_ns;
+    ev.spawn_real_ns = task->spawn_real_ns;
+    ev.start_real_ns = task->start_real_ns;
+    if (argc > 0) memcpy(ev.args, args, (size_t)argc * sizeof(args[0]));
+    if (type == TRACE_WORKER_TERMINATE) ev.overshoot_ns = sim_ns - task->end_ns;
+    spsc_push_wait(&pt->events, &ev);
+}
+
+// The next thing a task has to do: report the next second, or end
+static long long next_due(const struct Task *task) {
+    long long next_second = (long long)(task->last_reported_sec + 1) * 1000000000LL;
+    return next_second < task->end_ns ? next_second : task->end_ns;
+}
+
+static void *pool_main(void *arg) {
+    struct PoolThread *pt = arg;
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        int sec, nano;
+        segment_read_clock(seg, &seg->clock, &sec, &nano);
+        long long now_ns = (long long)sec * 1000000000LL + nano;
+
+        // New tasks start at the time of this pass, as a worker would on attach
+        struct TaskSpawn sp;
+        while (spsc_pop(&pt->spawns, &sp)) {
+            struct Task task;
+            memset(&task, 0, sizeof(task));
+            task.id                = sp.id;
+            task.start_sec         = sec;
+            task.last_reported_sec = sec;
+            task.reads             = 1;
+            task.end_ns            = now_ns + sp.lifetime_ns;
+            task.start_sim_ns      = now_ns;
+            task.spawn_real_ns     = sp.spawn_real_ns;
+            task.start_real_ns     = monotonic_ns();
+            task.next_ns           = next_due(&task);
+            const long long start_args[] = { task.end_ns / 1000000000LL, task.end_ns % 1000000000LL };
+            emit(pt, &task, TRACE_WORKER_START, now_ns, start_args, 2);
+            heap_push(pt, &task);
+        }
+
+        // Same checks as the worker loop, in the same order
+        while (pt->count > 0 && pt->heap[0].next_ns <= now_ns) {
+            struct Task task = heap_pop(pt);
+            task.reads++;
+            if (now_ns >= task.end_ns) {
+                emit(pt, &task, TRACE_WORKER_TERMINATE, now_ns, NULL, 0);
+                continue;
+            }
+            if (sec > task.last_reported_sec) {
+                const long long alive_args[] = { sec - task.start_sec };
+                emit(pt, &task, TRACE_WORKER_ALIVE, now_ns, alive_args, 1);
+                task.last_reported_sec = sec;
+            }
+            task.next_ns = next_due(&task);
+            heap_push(pt, &task);
+        }
+
+        // oss got SIGUSR2: every task prints the status line a worker would
+        unsigned int gen = __atomic_load_n(&report_gen, __ATOMIC_ACQUIRE);
+        if (gen != pt->report_seen) {
+            pt->report_seen = gen;
+            for (int i = 0; i < pt->count; i++) {
+                const struct Task *task       = &pt->heap[i];
+                const long long report_args[] = { task->end_ns / 1000000000LL, task->end_ns % 1000000000LL,
+                                                  (long long)task->reads };
+                emit(pt, task, TRACE_WORKER_REPORT, now_ns, report_args, 3);
+            }
+        }
+
+        if (pt->count > 0) {
+            clock_park(&seg->clock, pt->heap[0].next_ns, TASK_IDLE_NS, NULL, 0);
+        } else {
+            spsc_wait(&pt->spawns, &stopping, TASK_IDLE_NS);
+        }
+    }
+
+    // Stopped by oss: what a worker prints for CMD_TERMINATE
+    int sec, nano;
+    segment_read_clock(seg, &seg->clock, &sec, &nano);
+    long long now_ns = (long long)sec * 1000000000LL + nano;
+    for (int i = 0; i < pt->count; i++) {
+        const struct Task *task = &pt->heap[i];
+        const long long end_args[] = { task->end_ns / 1000000000LL, task->end_ns % 1000000000LL };
+        emit(pt, task, TRACE_WORKER_STOPPED, now_ns, end_args, 2);
+    }
+    pt->count = 0;
+    __atomic_store_n(&pt->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int taskpool_start(struct SharedSegment *segment, int threads, taskpool_event_fn on_event) {
+    seg          = segment;
+    handle_event = on_event;
+    stopping     = 0;
+    pool         = calloc((size_t)threads, sizeof(*pool));
+    if (!pool) {
+        perror("calloc task pool");
+        return -1;
+    }
+    for (int t = 0; t < threads; t++) {
+        struct PoolThread *pt = &pool[t];
+        pt->index             = t;
+        if (spsc_init(&pt->spawns, SPAWN_SLOTS, sizeof(struct TaskSpawn)) == -1 ||
+            spsc_init(&pt->events, EVENT_SLOTS, sizeof(struct TaskEvent)) == -1) {
+            perror("task pool queues");
+            taskpool_stop();
+            return -1;
+        }
+        int err = pthread_create(&pt->thread, NULL, pool_main, pt);
+        if (err != 0) {
+            fprintf(stderr, "pthread_create task pool: %s\n", strerror(err));
+            taskpool_stop();
+            return -1;
+        }
+        pool_size++;
+    }
+    return 0;
+}
+
+int taskpool_spawn(long long lifetime_ns) {
+    const struct TaskSpawn sp = { next_id, lifetime_ns, monotonic_ns() };
+    if (!spsc_push(&pool[next_thread].spawns, &sp)) return 0;
+    next_id++;
+    next_thread = (next_thread + 1) % pool_size;
+    return 1;
+}
+
+void taskpool_report(void) {
+    __atomic_add_fetch(&report_gen, 1u, __ATOMIC_RELEASE);
+}
+
+int taskpool_active(void) {
+    return next_id - finished;
+}
+
+void taskpool_collect(void) {
+    struct TaskEvent ev;
+    for (int t = 0; t < pool_size; t++) {
+        while (spsc_pop(&pool[t].events, &ev)) {
+            if (ev.type == TRACE_WORKER_TERMINATE || ev.type == TRACE_WORKER_STOPPED) finished++;
+            handle_event(&ev);
+        }
+    }
+}
+
+void taskpool_stop(void) {
+    if (!pool) return;
+    __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+    for (int t = 0; t < pool_size; t++) spsc_kick(&pool[t].spawns);
+
+    // The threads may block on full event queues, so keep draining until
+    // each has sent its last event
+    for (;;) {
+        int all_done = 1;
+        for (int t = 0; t < pool_size; t++) all_done &= __atomic_load_n(&pool[t].done, __ATOMIC_ACQUIRE);
+        taskpool_collect();
+        if (all_done) break;
+        const struct timespec backoff = { 0, SPSC_FULL_NS };
+        nanosleep(&backoff, NULL);
+    }
+    for (int t = 0; t < pool_size; t++) {
+        pthread_join(pool[t].thread, NULL);
+        spsc_free(&pool[t].spawns);
+        spsc_free(&pool[t].events);
+        free(pool[t].heap);
+    }
+    free(pool);
+    pool      = NULL;
+    pool_size = 0;
+}
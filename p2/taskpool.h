@@ -0,0 +1,71 @@
+// taskpool.h
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include "segment.h"
+
+/*
+ * oss -L: workers as tasks instead of processes. A fixed pool of threads
+ * inside oss runs them. A task is the free-running worker loop reduced to
+ * its state (start, end, last second reported), a few dozen bytes, so a
+ * run can hold 100k of them at once where fork+exec tops out at a few
+ * thousand.
+ *
+ * Each pool thread owns a shard of the tasks in a min-heap keyed by the
+ * next sim time the task has something to do: its next second or its
+ * end. A pass reads the clock once, handles only the tasks that are due
+ * and parks on the clock (clock_park) until the earliest of the rest, so
+ * the cost follows the events, not the number of tasks. New tasks and
+ * the lines a worker would print travel through one pair of
+ * single-producer / single-consumer queues per thread (spscq.h); oss
+ * emits the lines itself, so tracing and the logger stay on its thread.
+ */
+
+#define TASKPOOL_MAX_THREADS 64
+
+// Tasks print as "WORKER PID:<TASK_PID_BASE + id>". Linux pids never
+// reach this value (the pid_max limit), so a task cannot be confused with a process.
+#define TASK_PID_BASE 4194304
+
+// Pool thread -> oss: one line of worker output
+struct TaskEvent {
+  int type;                // TRACE_WORKER_START, _ALIVE, _REPORT, _TERMINATE or _STOPPED
+  int id;                  // task number, from 0 in spawn order
+  int thread;              // pool thread running the task
+  long long sim_ns;        // sim time the task saw
+  long long real_ns;       // when the pool thread saw it
+  long long args[3];       // as worker.c passes them
+  int argc;
+  // Set for TERMINATE and STOPPED
+  unsigned int reads;      // passes that looked at the task
+  long long overshoot_ns;  // TERMINATE only
+  long long start_sim_ns;
+  long long spawn_real_ns;
+  long long start_real_ns;
+};
+
+// Called on oss's thread for every event, in order per pool thread
+typedef void ( *taskpool_event_fn )( const struct TaskEvent *ev );
+
+// Start 'threads' pool threads reading the clock of 'segment'
+int taskpool_start( struct SharedSegment *segment, int threads, taskpool_event_fn on_event );
+
+// Start a task that lives lifetime_ns of sim time; 0 if its thread's queue is full
+int taskpool_spawn( long long lifetime_ns );
+
+// Have every running task report its status (TRACE_WORKER_REPORT), as
+// workers do for CMD_REPORT; each thread acts on it within 1 ms (real)
+void taskpool_report( void );
+
+// Tasks spawned and not yet seen to finish
+int taskpool_active( void );
+
+// Hand every queued event to on_event
+void taskpool_collect( void );
+
+// Stop the tasks still running (each reports TRACE_WORKER_STOPPED), pass
+// on everything queued and join the threads
+void taskpool_stop( void );
+
+#endif /* TASKPOOL_H */
@@ -0,0 +1,117 @@
+// timeline.c
+
+#include "timeline.h"
+#include "segment.h"
+#include "taskpool.h"
+#include <stdio.h>
+
+#define TIMELINE_SIM_PID  1
+#define TIMELINE_REAL_PID 2
+
+// Counter samples closer together than this (real time) are skipped
+#define TIMELINE_COUNTER_PERIOD_NS 10000000LL
+
+static FILE *timeline_fp         = NULL;
+static long long real_origin     = 0;
+static long long last_counter_ns = -TIMELINE_COUNTER_PERIOD_NS;
+static char named_slot[MAX_PROCESSES];
+static char named_thread[TASKPOOL_MAX_THREADS];
+
+// Every event after the first is preceded by a comma
+static void begin_event(void) {
+    fputs(",\n", timeline_fp);
+}
+
+static void name_track(int pid, int tid, const char *kind, const char *name) {
+    begin_event();
+    fprintf(timeline_fp, "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", kind, pid,
+            tid, name);
+}
+
+int timeline_open(const char *path, long long real_origin_ns) {
+    timeline_fp = fopen(path, "w");
+    if (!timeline_fp) {
+        perror("timeline open");
+        return -1;
+    }
+    // Spans are written at reap time; a large buffer keeps that off the syscall path
+    setvbuf(timeline_fp, NULL, _IOFBF, 1 << 20);
+    real_origin = real_origin_ns;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", timeline_fp);
+    fprintf(timeline_fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"sim time\"}}",
+            TIMELINE_SIM_PID);
+    name_track(TIMELINE_REAL_PID, 0, "process_name", "real time");
+    return 0;
+}
+
+int timeline_enabled(void) {
+    return timeline_fp != NULL;
+}
+
+// 'slot' is -1 for a task
+static void span(int pid, int tid, int slot, int worker, long long start_ns, long long end_ns) {
+    begin_event();
+    fprintf(timeline_fp,
+            "{\"name\":\"worker %d\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+            "\"args\":{\"pid\":%d,\"slot\":%d}}",
+            worker, pid, tid, (double)start_ns / 1000.0, (double)(end_ns - start_ns) / 1000.0, worker, slot);
+}
+
+void timeline_worker(int slot, int pid, long long spawn_sim_ns, long long reap_sim_ns, long long spawn_real_ns,
+                     long long reap_real_ns) {
+    if (!timeline_fp) return;
+    if (slot >= 0 && slot < MAX_PROCESSES && !named_slot[slot]) {
+        char name[32];
+        snprintf(name, sizeof(name), "slot %d", slot);
+        name_track(TIMELINE_SIM_PID, slot, "thread_name", name);
+        name_track(TIMELINE_REAL_PID, slot, "thread_name", name);
+        named_slot[slot] = 1;
+    }
+    span(TIMELINE_SIM_PID, slot, slot, pid, spawn_sim_ns, reap_sim_ns);
+    span(TIMELINE_REAL_PID, slot, slot, pid, spawn_real_ns - real_origin, reap_real_ns - real_origin);
+}
+
+void timeline_task(int thread, int pid, long long start_sim_ns, long long end_sim_ns, long long spawn_real_ns,
+                   long long end_real_ns) {
+    if (!timeline_fp || thread < 0 || thread >= TASKPOOL_MAX_THREADS) return;
+    // Pool threads get the tracks after the PCB slots
+    int tid = MAX_PROCESSES + thread;
+    if (!named_thread[thread]) {
+        char name[32];
+        snprintf(name, sizeof(name), "pool thread %d", thread);
+        name_track(TIMELINE_SIM_PID, tid, "thread_name", name);
+        name_track(TIMELINE_REAL_PID, tid, "thread_name", name);
+        named_thread[thread] = 1;
+    }
+    span(TIMELINE_SIM_PID, tid, -1, pid, start_sim_ns, end_sim_ns);
+    span(TIMELINE_REAL_PID, tid, -1, pid, spawn_real_ns - real_origin, end_real_ns - real_origin);
+}
+
+void timeline_counters(long long sim_ns, long long real_ns, int active, long long increment, double ratio) {
+    if (!timeline_fp || real_ns - last_counter_ns < TIMELINE_COUNTER_PERIOD_NS) return;
+    last_counter_ns = real_ns;
+
+    const int pids[2]        = { TIMELINE_SIM_PID, TIMELINE_REAL_PID };
+    const long long ts_ns[2] = { sim_ns, real_ns - real_origin };
+    for (int i = 0; i < 2; i++) {
+        double ts = (double)ts_ns[i] / 1000.0;
+        begin_event();
+        fprintf(timeline_fp, "{\"name\":\"active\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{\"workers\":%d}}",
+                pids[i], ts, active);
+        begin_event();
+        fprintf(timeline_fp,
+                "{\"name\":\"current_increment\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{\"ns\":%lld}}",
+                pids[i], ts, increment);
+        begin_event();
+        fprintf(timeline_fp, "{\"name\":\"sim/real\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{\"ratio\":%.4f}}",
+                pids[i], ts, ratio);
+    }
+}
+
+void timeline_close(void) {
+    if (!timeline_fp) return;
+    fputs("\n]}\n", timeline_fp);
+    fclose(timeline_fp);
+    timeline_fp = NULL;
+}
@@ -0,0 +1,36 @@
+// timeline.h
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+/*
+ * Chrome trace-event JSON export (oss -j), loadable in chrome://tracing
+ * or ui.perfetto.dev. Two "processes" hold the same picture on different
+ * time bases: pid 1 is simulated time, pid 2 is real time. Each PCB slot
+ * is a track (tid) on which every worker is a span from spawn to reap;
+ * under oss -L each pool thread is a track of task spans instead. Both
+ * processes carry counter tracks for the active worker count,
+ * current_increment and the sim/real ratio. Timestamps are microseconds
+ * since oss started.
+ */
+
+// Open the JSON file and write the preamble. Returns 0 or -1.
+int timeline_open( const char *path, long long real_origin_ns );
+
+int timeline_enabled( void );
+
+// A worker's lifetime on both time bases, emitted when it is reaped
+void timeline_worker( int slot, int pid, long long spawn_sim_ns, long long reap_sim_ns, long long spawn_real_ns,
+                      long long reap_real_ns );
+
+// A task's lifetime (oss -L), emitted when it ends, on its pool thread's track
+void timeline_task( int thread, int pid, long long start_sim_ns, long long end_sim_ns, long long spawn_real_ns,
+                    long long end_real_ns );
+
+// Counter samples (offered on every pass of the oss loop, kept at most every 10 ms)
+void timeline_counters( long long sim_ns, long long real_ns, int active, long long increment, double ratio );
+
+// Terminate the JSON array and close the file
+void timeline_close( void );
+
+#endif /* TIMELINE_H */
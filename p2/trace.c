@@ -0,0 +1,111 @@
+// trace.c
+
+#include "trace.h"
+#include "clock.h"
+#include "tracetext.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_BUFFER_SIZE 65536
+
+static int trace_fd    = -1;
+static pid_t trace_pid = 0;
+
+// Optional consumer of text-mode events (oss's logger thread)
+static void (*text_sink)(const struct TraceRecord *, const long long *) = NULL;
+
+// Whole records only; flushed with one write() when the next one won't fit
+static unsigned char trace_buf[TRACE_BUFFER_SIZE];
+static size_t trace_used = 0;
+
+static void trace_flush(void) {
+    size_t off = 0;
+    while (off < trace_used) {
+        ssize_t n = write(trace_fd, trace_buf + off, trace_used - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("trace write");
+            break;
+        }
+        off += (size_t)n;
+    }
+    trace_used = 0;
+}
+
+int trace_create(const char *path) {
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (trace_fd == -1) {
+        perror("trace open");
+        return -1;
+    }
+    unsigned char hdr[TRACE_HEADER_SIZE];
+    trace_encode_header(hdr);
+    if (write(trace_fd, hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+        perror("trace header");
+        close(trace_fd);
+        trace_fd = -1;
+        return -1;
+    }
+    trace_pid = getpid();
+    // Children find the file through the environment across exec
+    setenv(TRACE_ENV, path, 1);
+    return 0;
+}
+
+void trace_open_from_env(void) {
+    const char *path = getenv(TRACE_ENV);
+    if (!path || !*path) return;
+    trace_fd = open(path, O_WRONLY | O_APPEND);
+    if (trace_fd == -1) {
+        perror("trace open (worker)");
+        return;
+    }
+    trace_pid = getpid();
+}
+
+void trace_set_text_sink(void (*sink)(const struct TraceRecord *rec, const long long *args)) {
+    text_sink = sink;
+}
+
+int trace_enabled(void) {
+    return trace_fd != -1;
+}
+
+void trace_event(int type, int slot, long long sim_ns, const long long *args, int argc) {
+    trace_event_pid(trace_pid ? trace_pid : getpid(), type, slot, sim_ns, args, argc);
+}
+
+void trace_event_pid(pid_t pid, int type, int slot, long long sim_ns, const long long *args, int argc) {
+    struct TraceRecord rec;
+    rec.type    = (unsigned char)type;
+    rec.argc    = (unsigned char)argc;
+    rec.slot    = (short)slot;
+    rec.pid     = (int)pid;
+    rec.sim_ns  = sim_ns;
+    rec.real_ns = monotonic_ns();
+
+    if (trace_fd == -1) {
+        if (text_sink) {
+            text_sink(&rec, args);
+        } else {
+            trace_render_text(stdout, &rec, args);
+        }
+        return;
+    }
+
+    size_t need = TRACE_RECORD_SIZE + (size_t)argc * TRACE_ARG_SIZE;
+    if (trace_used + need > sizeof(trace_buf)) {
+        trace_flush();
+    }
+    trace_used += trace_encode_record(trace_buf + trace_used, &rec, args);
+}
+
+void trace_close(void) {
+    if (trace_fd == -1) return;
+    trace_flush();
+    close(trace_fd);
+    trace_fd = -1;
+}
@@ -0,0 +1,45 @@
+// trace.h
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "tracefmt.h"
+#include <sys/types.h>
+
+/*
+ * Structured event log for oss and worker output. Every status line is
+ * an event: a fixed header plus up to TRACE_MAX_ARGS 64-bit arguments.
+ * Without a trace file the event is rendered straight to stdout
+ * (tracetext.h), exactly as the old printf did. With a trace file
+ * (oss -T) events are encoded (tracefmt.h) and appended through a
+ * per-process buffer and all text formatting happens later in the
+ * tracedump tool.
+ *
+ * Several processes append to the same file with O_APPEND; each flush is
+ * a single write() of whole records so they never interleave mid-record.
+ */
+
+#define TRACE_ENV          "OSS_TRACE_FILE"
+
+// oss: create (truncate) the trace file and export its path to children
+int trace_create( const char *path );
+
+// worker: append to the trace file named in the environment, if any
+void trace_open_from_env( void );
+
+// 1 if events go to a binary trace file rather than stdout
+int trace_enabled( void );
+
+// Emit one event (binary append, or render to stdout when not tracing)
+void trace_event( int type, int slot, long long sim_ns, const long long *args, int argc );
+
+// Same on behalf of 'pid' (oss -L: worker lines of in-process tasks)
+void trace_event_pid( pid_t pid, int type, int slot, long long sim_ns, const long long *args, int argc );
+
+// Hand text-mode events to 'sink' instead of rendering them inline (NULL restores stdout)
+void trace_set_text_sink( void ( *sink )( const struct TraceRecord *rec, const long long *args ) );
+
+// Flush buffered records and close the trace file
+void trace_close( void );
+
+#endif /* TRACE_H */
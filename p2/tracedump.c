@@ -0,0 +1,124 @@
+/*
+ * tracedump: render a binary trace written by `oss -T <file>`.
+ *
+ * Usage: tracedump [-c] [-r] <trace file>
+ *   -c  CSV output (event,pid,slot,sim_ns,real_ns,args...) instead of text
+ *   -r  keep file order instead of sorting events by real time
+ *
+ * Text output reproduces the lines oss and worker print without -T.
+ * Records from different processes reach the file in flush order, so by
+ * default they are sorted (stably) by their real timestamp first.
+ */
+
+// tracedump.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tracetext.h"
+
+struct LoadedEvent {
+    struct TraceRecord rec;
+    long long args[TRACE_MAX_ARGS];
+    size_t order;  // position in the file, keeps the sort stable
+};
+
+static int by_real_time(const void *pa, const void *pb) {
+    const struct LoadedEvent *a = pa;
+    const struct LoadedEvent *b = pb;
+    if (a->rec.real_ns != b->rec.real_ns) return a->rec.real_ns < b->rec.real_ns ? -1 : 1;
+    if (a->order != b->order) return a->order < b->order ? -1 : 1;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int csv = 0, raw = 0;
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            csv = 1;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            raw = 1;
+        } else if (strcmp(argv[i], "-h") == 0) {
+            printf("Usage: %s [-c] [-r] <trace file>\n", argv[0]);
+            return 0;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [-c] [-r] <trace file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return 1;
+    }
+    unsigned char buf[TRACE_RECORD_SIZE + TRACE_MAX_ARGS * TRACE_ARG_SIZE];
+    struct TraceFileHeader hdr;
+    if (fread(buf, TRACE_HEADER_SIZE, 1, fp) != 1 || trace_decode_header(buf, &hdr) != 0) {
+        fprintf(stderr, "%s: not an oss trace file\n", path);
+        fclose(fp);
+        return 1;
+    }
+    if (hdr.version != TRACE_VERSION || hdr.record_size != TRACE_RECORD_SIZE) {
+        fprintf(stderr, "%s: unsupported trace version %u (this tracedump reads version %d)\n", path, hdr.version,
+                TRACE_VERSION);
+        fclose(fp);
+        return 1;
+    }
+
+    size_t count = 0, cap = 1024;
+    struct LoadedEvent *events = malloc(cap * sizeof(*events));
+    if (!events) {
+        perror("malloc");
+        fclose(fp);
+        return 1;
+    }
+    struct TraceRecord rec;
+    while (fread(buf, TRACE_RECORD_SIZE, 1, fp) == 1) {
+        trace_decode_record(buf, &rec);
+        if (rec.argc > TRACE_MAX_ARGS) {
+            fprintf(stderr, "%s: corrupt record after %zu events\n", path, count);
+            break;
+        }
+        if (count == cap) {
+            cap *= 2;
+            struct LoadedEvent *grown = realloc(events, cap * sizeof(*events));
+            if (!grown) {
+                perror("realloc");
+                break;
+            }
+            events = grown;
+        }
+        struct LoadedEvent *ev = &events[count];
+        ev->rec   = rec;
+        ev->order = count;
+        if (rec.argc && fread(buf, TRACE_ARG_SIZE, rec.argc, fp) != rec.argc) {
+            fprintf(stderr, "%s: truncated record after %zu events\n", path, count);
+            break;
+        }
+        trace_decode_args(buf, rec.argc, ev->args);
+        count++;
+    }
+    fclose(fp);
+
+    if (!raw) {
+        qsort(events, count, sizeof(*events), by_real_time);
+    }
+    if (csv) {
+        printf("event,pid,slot,sim_ns,real_ns,args\n");
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (csv) {
+            trace_render_csv(stdout, &events[i].rec, events[i].args);
+        } else {
+            trace_render_text(stdout, &events[i].rec, events[i].args);
+        }
+    }
+    free(events);
+    return 0;
+}
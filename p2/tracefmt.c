@@ -0,0 +1,116 @@
+// tracefmt.c
+
+#include "tracefmt.h"
+#include <string.h>
+
+static const char *event_names[TRACE_EVENT_COUNT] = {
+    "?",
+    "worker_start",
+    "worker_alive",
+    "worker_terminate",
+    "worker_stopped",
+    "worker_report",
+    "worker_reclaimed",
+    "table_begin",
+    "table_placement",
+    "table_header",
+    "table_row",
+    "table_counters",
+    "table_end",
+    "totals",
+    "delta_begin",
+    "delta_add",
+    "delta_remove",
+    "delta_state",
+    "latency",
+    "perf",
+    "sched",
+    "sched_levels",
+    "dispatcher",
+    "autoscale",
+    "autoscale_summary",
+    "usage",
+    "deadlock",
+    "resources",
+    "deadlock_stats",
+    "paging",
+    "paging_device",
+    "io_device",
+    "tasks",
+};
+
+// Fixed-width little-endian fields, whatever the host's byte order
+
+static void put_u16(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, unsigned int v) {
+    put_u16(p, v & 0xffffu);
+    put_u16(p + 2, v >> 16);
+}
+
+static void put_i64(unsigned char *p, long long v) {
+    unsigned long long u = (unsigned long long)v;
+    put_u32(p, (unsigned int)(u & 0xffffffffu));
+    put_u32(p + 4, (unsigned int)(u >> 32));
+}
+
+static unsigned int get_u16(const unsigned char *p) {
+    return (unsigned int)p[0] | (unsigned int)p[1] << 8;
+}
+
+static unsigned int get_u32(const unsigned char *p) {
+    return get_u16(p) | get_u16(p + 2) << 16;
+}
+
+static long long get_i64(const unsigned char *p) {
+    return (long long)((unsigned long long)get_u32(p) | (unsigned long long)get_u32(p + 4) << 32);
+}
+
+void trace_encode_header(unsigned char *buf) {
+    memcpy(buf, TRACE_MAGIC, 8);
+    put_u32(buf + 8, TRACE_VERSION);
+    put_u32(buf + 12, TRACE_RECORD_SIZE);
+}
+
+int trace_decode_header(const unsigned char *buf, struct TraceFileHeader *hdr) {
+    memcpy(hdr->magic, buf, sizeof(hdr->magic));
+    hdr->version     = get_u32(buf + 8);
+    hdr->record_size = get_u32(buf + 12);
+    return memcmp(hdr->magic, TRACE_MAGIC, sizeof(hdr->magic)) == 0 ? 0 : -1;
+}
+
+size_t trace_encode_record(unsigned char *buf, const struct TraceRecord *rec, const long long *args) {
+    buf[0] = rec->type;
+    buf[1] = rec->argc;
+    put_u16(buf + 2, (unsigned int)(unsigned short)rec->slot);
+    put_u32(buf + 4, (unsigned int)rec->pid);
+    put_i64(buf + 8, rec->sim_ns);
+    put_i64(buf + 16, rec->real_ns);
+    for (int i = 0; i < rec->argc; i++) {
+        put_i64(buf + TRACE_RECORD_SIZE + (size_t)i * TRACE_ARG_SIZE, args[i]);
+    }
+    return TRACE_RECORD_SIZE + (size_t)rec->argc * TRACE_ARG_SIZE;
+}
+
+void trace_decode_record(const unsigned char *buf, struct TraceRecord *rec) {
+    rec->type    = buf[0];
+    rec->argc    = buf[1];
+    rec->slot    = (short)get_u16(buf + 2);
+    rec->pid     = (int)get_u32(buf + 4);
+    rec->sim_ns  = get_i64(buf + 8);
+    rec->real_ns = get_i64(buf + 16);
+}
+
+void trace_decode_args(const unsigned char *buf, int argc, long long *args) {
+    for (int i = 0; i < argc; i++) {
+        args[i] = get_i64(buf + (size_t)i * TRACE_ARG_SIZE);
+    }
+}
+
+const char *trace_event_name(int type) {
+    if (type <= 0 || type >= TRACE_EVENT_COUNT) return event_names[0];
+    return event_names[type];
+}
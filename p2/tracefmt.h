@@ -0,0 +1,103 @@
+// tracefmt.h
+
+#ifndef TRACEFMT_H
+#define TRACEFMT_H
+
+#include <stddef.h>
+
+/*
+ * On-disk format of oss -T trace files. The file starts with a
+ * TRACE_HEADER_SIZE byte header and is followed by records, each a
+ * TRACE_RECORD_SIZE byte header plus 'argc' 64-bit arguments. Every
+ * field has a fixed width and offset and is stored little-endian, with
+ * no padding anywhere:
+ *
+ *   header:  0 magic[8]  8 u32 version  12 u32 record_size
+ *   record:  0 u8 type  1 u8 argc  2 i16 slot  4 i32 pid  8 i64 sim_ns  16 i64 real_ns
+ *
+ * The in-memory structs below are never written as they are; the
+ * encoders lay the bytes out. Bump TRACE_VERSION whenever the layout or
+ * the meaning of an event's arguments changes.
+ */
+
+#define TRACE_MAGIC        "OSSTRACE"
+#define TRACE_VERSION      2
+#define TRACE_HEADER_SIZE  16
+#define TRACE_RECORD_SIZE  24
+#define TRACE_ARG_SIZE     8
+#define TRACE_MAX_ARGS     8
+
+enum TraceEvent {
+  TRACE_WORKER_START = 1,  // args: end_sec, end_nano
+  TRACE_WORKER_ALIVE,      // args: seconds since start
+  TRACE_WORKER_TERMINATE,  // (sim_ns is the time it noticed)
+  TRACE_WORKER_STOPPED,    // terminated by oss; args: end_sec, end_nano
+  TRACE_WORKER_REPORT,     // args: end_sec, end_nano, clock_reads
+  TRACE_WORKER_RECLAIMED,  // segment was reclaimed by a new oss
+  TRACE_TABLE_BEGIN,       // args: current_increment
+  TRACE_TABLE_PLACEMENT,   // args: policy, oss cpu, oss node
+  TRACE_TABLE_HEADER,      //
+  TRACE_TABLE_ROW,         // args: pid, startSec, startNano [, cpu, node]
+  TRACE_TABLE_COUNTERS,    // args: see TRACE_TOTALS
+  TRACE_TABLE_END,         //
+  TRACE_TOTALS,            // args: workers, clock_reads, loop_iterations, startup avg us,
+                           //       startup max us, overshoot avg ns, overshoot max ns
+  TRACE_DELTA_BEGIN,       // args: current_increment, changes, snapshots until next keyframe
+  TRACE_DELTA_ADD,         // args: as TRACE_TABLE_ROW
+  TRACE_DELTA_REMOVE,      // args: pid
+  TRACE_DELTA_STATE,       // args: pid, old state, new state (enum PcbState)
+  TRACE_LATENCY,           // args: kind (enum LatencyKind), count, min, p50, p90, p99, p99.9, max
+  TRACE_PERF,              // args: scope (enum PerfScope), processes, then one per enum PerfCounterKind
+  TRACE_SCHED,             // args: dispatches, dispatches per real second, preemptions, blocks, exits,
+                           //       boosts, busy sim ns, idle sim ns
+  TRACE_SCHED_LEVELS,      // args: dispatches at each MLFQ level, highest first
+  TRACE_DISPATCHER,        // args: dispatcher, dispatches, steals, preemptions, blocks, exits, busy sim ns
+  TRACE_AUTOSCALE,         // args: old ceiling, new ceiling, sim/real x1000, cpu pressure x1000 (-1 = n/a),
+                           //       active, cpus
+  TRACE_AUTOSCALE_SUMMARY, // args: final ceiling, lowest, highest, changes, workers reaped, real ms
+  TRACE_USAGE,             // args: kind (enum UsageKind), workers, total, min, p50, p90, p99, max
+  TRACE_DEADLOCK,          // args: workers deadlocked, victim pid, instances it held
+  TRACE_RESOURCES,         // args: classes, instances each, requests, granted at once, waited, releases
+  TRACE_DEADLOCK_STATS,    // args: detections, deadlocks found, victims, avg detection real ns, max
+  TRACE_PAGING,            // args: policy, frames, frames in use, references, faults, evictions, write-backs
+  TRACE_PAGING_DEVICE,     // args: device operations, avg queue wait sim ns, max
+  TRACE_IO_DEVICE,         // args: device, policy, completed, avg wait ns, avg service ns, max queue, busy ns, cylinders
+  TRACE_TASKS,             // args: active, launched, finished, pool threads
+  TRACE_EVENT_COUNT
+};
+
+struct TraceFileHeader {
+  char magic[8];             // TRACE_MAGIC
+  unsigned int version;      // TRACE_VERSION
+  unsigned int record_size;  // TRACE_RECORD_SIZE, args excluded
+};
+
+struct TraceRecord {
+  unsigned char type;  // enum TraceEvent
+  unsigned char argc;  // number of 64-bit args following the header
+  short slot;          // PCB slot, -1 if none
+  int pid;             // emitting process
+  long long sim_ns;    // SysClock when the event happened
+  long long real_ns;   // CLOCK_MONOTONIC when the event happened
+};
+
+// Write this build's file header into buf[TRACE_HEADER_SIZE]
+void trace_encode_header( unsigned char *buf );
+
+// Read a file header; -1 if the magic does not match
+int trace_decode_header( const unsigned char *buf, struct TraceFileHeader *hdr );
+
+// Write a record and its args into buf; returns the bytes written
+// (TRACE_RECORD_SIZE + argc * TRACE_ARG_SIZE)
+size_t trace_encode_record( unsigned char *buf, const struct TraceRecord *rec, const long long *args );
+
+// Read a record header from buf[TRACE_RECORD_SIZE]
+void trace_decode_record( const unsigned char *buf, struct TraceRecord *rec );
+
+// Read 'argc' args that follow a record header
+void trace_decode_args( const unsigned char *buf, int argc, long long *args );
+
+// Event name used in CSV output
+const char *trace_event_name( int type );
+
+#endif /* TRACEFMT_H */
@@ -0,0 +1,243 @@
+// tracetext.c
+
+#include "tracetext.h"
+#include "hist.h"
+#include "iodev.h"
+#include "pager.h"
+#include "perfctr.h"
+#include "placement.h"
+#include "segment.h"
+
+static long long arg_or_zero(const struct TraceRecord *rec, const long long *args, int i) {
+    return i < rec->argc ? args[i] : 0;
+}
+
+// Counter value for TRACE_PERF lines, "n/a" when the host lacks the event
+static const char *perf_value(char *buf, size_t size, const struct TraceRecord *rec, const long long *args,
+                              int kind) {
+    int i = 2 + kind;
+    if (i >= rec->argc || args[i] < 0) return "n/a";
+    snprintf(buf, size, "%lld", args[i]);
+    return buf;
+}
+
+static int format_perf(char *buf, size_t size, const struct TraceRecord *rec, const long long *args) {
+    char who[48], v[PERF_KIND_COUNT][24];
+    long long scope = arg_or_zero(rec, args, 0);
+    if (scope == PERF_SCOPE_WORKER) {
+        snprintf(who, sizeof(who), "WORKER PID:%d perf", (int)rec->pid);
+    } else if (scope == PERF_SCOPE_WORKERS) {
+        snprintf(who, sizeof(who), "OSS: perf workers (%lld)", arg_or_zero(rec, args, 1));
+    } else {
+        snprintf(who, sizeof(who), "OSS: perf oss loop");
+    }
+    const char *val[PERF_KIND_COUNT];
+    for (int k = 0; k < PERF_KIND_COUNT; k++) {
+        val[k] = perf_value(v[k], sizeof(v[k]), rec, args, k);
+    }
+    return snprintf(buf, size, "%s: cycles=%s instructions=%s cache_misses=%s ctx_switches=%s task_clock_ns=%s\n",
+                    who, val[PERF_CYCLES], val[PERF_INSTRUCTIONS], val[PERF_CACHE_MISSES],
+                    val[PERF_CONTEXT_SWITCHES], val[PERF_TASK_CLOCK]);
+}
+
+int trace_format_text(char *buf, size_t size, const struct TraceRecord *rec, const long long *args) {
+    int pid     = (int)rec->pid;
+    int sim_s   = (int)(rec->sim_ns / 1000000000LL);
+    int sim_ns  = (int)(rec->sim_ns % 1000000000LL);
+    long long a = arg_or_zero(rec, args, 0);
+    long long b = arg_or_zero(rec, args, 1);
+    long long c = arg_or_zero(rec, args, 2);
+    int n       = 0;
+
+    switch (rec->type) {
+    case TRACE_WORKER_START:
+        n = snprintf(buf, size, "WORKER PID:%d Start: %d s, %d ns -> End: %lld s, %lld ns\n",
+                     pid, sim_s, sim_ns, a, b);
+        break;
+    case TRACE_WORKER_ALIVE:
+        n = snprintf(buf, size, "WORKER PID:%d alive for %lld seconds\n", pid, a);
+        break;
+    case TRACE_WORKER_TERMINATE:
+        n = snprintf(buf, size, "WORKER PID:%d terminating at %d s, %d ns\n", pid, sim_s, sim_ns);
+        break;
+    case TRACE_WORKER_STOPPED:
+        n = snprintf(buf, size, "WORKER PID:%d terminating at %d s, %d ns (oss request, end was %lld s, %lld ns)\n",
+                     pid, sim_s, sim_ns, a, b);
+        break;
+    case TRACE_WORKER_REPORT:
+        n = snprintf(buf, size, "WORKER PID:%d report at %d s, %d ns -> End: %lld s, %lld ns, clock reads %lld\n",
+                     pid, sim_s, sim_ns, a, b, c);
+        break;
+    case TRACE_WORKER_RECLAIMED:
+        n = snprintf(buf, size, "WORKER PID:%d segment reclaimed by a new oss, exiting\n", pid);
+        break;
+    case TRACE_TABLE_BEGIN:
+        n = snprintf(buf, size, "\nOSS: SysClock %d s, %d ns, incr=%lld\n", sim_s, sim_ns, a);
+        break;
+    case TRACE_TABLE_PLACEMENT:
+        n = snprintf(buf, size, "Placement: %s, oss on cpu %lld (node %lld)\n",
+                     placement_policy_name((int)a), b, c);
+        break;
+    case TRACE_TABLE_HEADER:
+        n = snprintf(buf, size, "Process Table (PID / startSec / startNano):\n");
+        break;
+    case TRACE_TABLE_ROW:
+        if (rec->argc >= 5) {
+            n = snprintf(buf, size, "  [%2d] pid=%lld start=(%lld, %lld) cpu=%lld node=%lld\n",
+                         rec->slot, a, b, c, args[3], args[4]);
+        } else {
+            n = snprintf(buf, size, "  [%2d] pid=%lld start=(%lld, %lld)\n", rec->slot, a, b, c);
+        }
+        break;
+    case TRACE_TABLE_COUNTERS:
+    case TRACE_TOTALS:
+        n = snprintf(buf, size,
+                     "%s: workers=%lld clock_reads=%lld loop_iterations=%lld startup avg=%lld us max=%lld us "
+                     "overshoot avg=%lld ns max=%lld ns\n",
+                     rec->type == TRACE_TOTALS ? "OSS: worker totals" : "Counters",
+                     a, b, c, arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4),
+                     arg_or_zero(rec, args, 5), arg_or_zero(rec, args, 6));
+        break;
+    case TRACE_TABLE_END:
+        n = snprintf(buf, size, "\n");
+        break;
+    case TRACE_DELTA_BEGIN:
+        n = snprintf(buf, size, "\nOSS: SysClock %d s, %d ns, incr=%lld, delta: %lld change(s), keyframe in %lld\n",
+                     sim_s, sim_ns, a, b, c);
+        break;
+    case TRACE_DELTA_ADD:
+        if (rec->argc >= 5) {
+            n = snprintf(buf, size, "  + [%2d] pid=%lld start=(%lld, %lld) cpu=%lld node=%lld\n",
+                         rec->slot, a, b, c, args[3], args[4]);
+        } else {
+            n = snprintf(buf, size, "  + [%2d] pid=%lld start=(%lld, %lld)\n", rec->slot, a, b, c);
+        }
+        break;
+    case TRACE_DELTA_REMOVE:
+        n = snprintf(buf, size, "  - [%2d] pid=%lld\n", rec->slot, a);
+        break;
+    case TRACE_DELTA_STATE:
+        n = snprintf(buf, size, "  ~ [%2d] pid=%lld %s -> %s\n", rec->slot, a, pcb_state_name((int)b),
+                     pcb_state_name((int)c));
+        break;
+    case TRACE_LATENCY:
+        n = snprintf(buf, size,
+                     "OSS: latency %s (%s ns): n=%lld min=%lld p50=%lld p90=%lld p99=%lld p99.9=%lld max=%lld\n",
+                     latency_kind_name((int)a), a == LAT_OVERSHOOT ? "sim" : "real", b, c,
+                     arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5),
+                     arg_or_zero(rec, args, 6), arg_or_zero(rec, args, 7));
+        break;
+    case TRACE_USAGE:
+        n = snprintf(buf, size,
+                     "OSS: worker usage %s (%s): n=%lld total=%lld min=%lld p50=%lld p90=%lld p99=%lld max=%lld\n",
+                     usage_kind_name((int)a), usage_kind_unit((int)a), b, c, arg_or_zero(rec, args, 3),
+                     arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5), arg_or_zero(rec, args, 6),
+                     arg_or_zero(rec, args, 7));
+        break;
+    case TRACE_DEADLOCK:
+        n = snprintf(buf, size, "OSS: deadlock at %d s, %d ns among %lld workers, terminating PID %lld (holds %lld)\n",
+                     sim_s, sim_ns, a, b, c);
+        break;
+    case TRACE_RESOURCES:
+        n = snprintf(buf, size,
+                     "OSS: resources: %lld classes x %lld instances, requests=%lld (granted at once=%lld, "
+                     "waited=%lld) releases=%lld\n",
+                     a, b, c, arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5));
+        break;
+    case TRACE_DEADLOCK_STATS:
+        n = snprintf(buf, size,
+                     "OSS: deadlock detection: runs=%lld deadlocks=%lld victims=%lld time avg=%.1f us max=%.1f us\n",
+                     a, b, c, (double)arg_or_zero(rec, args, 3) / 1e3, (double)arg_or_zero(rec, args, 4) / 1e3);
+        break;
+    case TRACE_PAGING: {
+        long long refs = arg_or_zero(rec, args, 3), faults = arg_or_zero(rec, args, 4);
+        n = snprintf(buf, size,
+                     "OSS: paging (%s): %lld of %lld frames in use, references=%lld faults=%lld (%.2f%%) "
+                     "evictions=%lld dirty write-backs=%lld\n",
+                     page_policy_name((int)a), c, b, refs, faults, refs ? 100.0 * (double)faults / (double)refs : 0.0,
+                     arg_or_zero(rec, args, 5), arg_or_zero(rec, args, 6));
+        break;
+    }
+    case TRACE_PAGING_DEVICE:
+        n = snprintf(buf, size, "OSS: paging device: operations=%lld queue wait avg=%.3f ms max=%.3f ms\n", a,
+                     (double)b / 1e6, (double)c / 1e6);
+        break;
+    case TRACE_IO_DEVICE: {
+        long long busy = arg_or_zero(rec, args, 6);
+        n = snprintf(buf, size,
+                     "OSS: I/O device %lld (%s): completed=%lld wait avg=%.3f ms service avg=%.3f ms max queue=%lld "
+                     "busy=%.1f%% head moved %lld cylinders\n",
+                     a, io_policy_name((int)b), c, (double)arg_or_zero(rec, args, 3) / 1e6,
+                     (double)arg_or_zero(rec, args, 4) / 1e6, arg_or_zero(rec, args, 5),
+                     rec->sim_ns > 0 ? 100.0 * (double)busy / (double)rec->sim_ns : 0.0, arg_or_zero(rec, args, 7));
+        break;
+    }
+    case TRACE_TASKS:
+        n = snprintf(buf, size, "Tasks: active=%lld launched=%lld finished=%lld pool threads=%lld\n", a, b, c,
+                     arg_or_zero(rec, args, 3));
+        break;
+    case TRACE_PERF:
+        n = format_perf(buf, size, rec, args);
+        break;
+    case TRACE_SCHED:
+        n = snprintf(buf, size,
+                     "OSS: scheduler: dispatches=%lld (%lld/s) preempted=%lld blocked=%lld exited=%lld boosts=%lld "
+                     "busy=%lld ms idle=%lld ms\n",
+                     a, b, c, arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5),
+                     arg_or_zero(rec, args, 6) / 1000000, arg_or_zero(rec, args, 7) / 1000000);
+        break;
+    case TRACE_DISPATCHER:
+        n = snprintf(buf, size,
+                     "OSS: dispatcher %lld: dispatches=%lld steals=%lld preempted=%lld blocked=%lld exited=%lld "
+                     "busy=%lld ms\n",
+                     a, b, c, arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5),
+                     arg_or_zero(rec, args, 6) / 1000000);
+        break;
+    case TRACE_AUTOSCALE: {
+        char ratio[16] = "n/a", pressure[16] = "n/a";
+        long long psi = arg_or_zero(rec, args, 3);
+        if (c >= 0) snprintf(ratio, sizeof(ratio), "%.2f", (double)c / 1000.0);
+        if (psi >= 0) snprintf(pressure, sizeof(pressure), "%.0f%%", (double)psi / 10.0);
+        n = snprintf(buf, size,
+                     "OSS: -s auto: simul %lld -> %lld (sim/real %s, cpu pressure %s, active %lld, cpus %lld)\n",
+                     a, b, ratio, pressure, arg_or_zero(rec, args, 4), arg_or_zero(rec, args, 5));
+        break;
+    }
+    case TRACE_AUTOSCALE_SUMMARY: {
+        long long ms = arg_or_zero(rec, args, 5);
+        n = snprintf(buf, size,
+                     "OSS: -s auto: final simul=%lld range=%lld..%lld changes=%lld, %lld workers in %lld ms (%.2f/s)\n",
+                     a, b, c, arg_or_zero(rec, args, 3), arg_or_zero(rec, args, 4), ms,
+                     ms > 0 ? (double)arg_or_zero(rec, args, 4) * 1000.0 / (double)ms : 0.0);
+        break;
+    }
+    case TRACE_SCHED_LEVELS: {
+        int len = snprintf(buf, size, "OSS: scheduler dispatches by level:");
+        for (int i = 0; i < rec->argc && len >= 0 && (size_t)len < size; i++) {
+            len += snprintf(buf + len, size - (size_t)len, " L%d=%lld", i, args[i]);
+        }
+        if (len >= 0 && (size_t)len < size) len += snprintf(buf + len, size - (size_t)len, "\n");
+        n = len;
+        break;
+    }
+    default:
+        n = snprintf(buf, size, "?? event %d from pid %d\n", rec->type, pid);
+        break;
+    }
+    return n < 0 ? 0 : ((size_t)n >= size ? (int)size - 1 : n);
+}
+
+void trace_render_text(FILE *out, const struct TraceRecord *rec, const long long *args) {
+    char line[TRACE_TEXT_MAX];
+    trace_format_text(line, sizeof(line), rec, args);
+    fputs(line, out);
+}
+
+void trace_render_csv(FILE *out, const struct TraceRecord *rec, const long long *args) {
+    fprintf(out, "%s,%d,%d,%lld,%lld", trace_event_name(rec->type), (int)rec->pid, rec->slot,
+            rec->sim_ns, rec->real_ns);
+    for (int i = 0; i < rec->argc; i++) {
+        fprintf(out, ",%lld", args[i]);
+    }
+    fprintf(out, "\n");
+}
@@ -0,0 +1,26 @@
+// tracetext.h
+
+#ifndef TRACETEXT_H
+#define TRACETEXT_H
+
+#include "tracefmt.h"
+#include <stdio.h>
+
+/*
+ * Text and CSV rendering of trace events, shared by the processes that
+ * print their own lines and by tracedump. Only needs the headers of the
+ * modules whose enums it names, so linking it pulls in nothing else.
+ */
+
+#define TRACE_TEXT_MAX 256  // longest rendered event, newline included
+
+// Render one event as the text line(s) the programs print
+void trace_render_text( FILE *out, const struct TraceRecord *rec, const long long *args );
+
+// Same into a buffer; returns the length written (truncated to size - 1)
+int trace_format_text( char *buf, size_t size, const struct TraceRecord *rec, const long long *args );
+
+// Render one event as a CSV row: type,pid,slot,sim_ns,real_ns,args...
+void trace_render_csv( FILE *out, const struct TraceRecord *rec, const long long *args );
+
+#endif /* TRACETEXT_H */
@@ -57,39 +57,278 @@
 
 // worker.c
 
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include "clock.h"
+#include "doorbell.h"
+#include "iodev.h"
+#include "mlfq.h"
+#include "pager.h"
+#include "perfctr.h"
+#include "resmgr.h"
+#include "segment.h"
 #include "shared.h"
+#include "trace.h"
+
+// Under oss -m: chance of blocking inside a quantum, and how long a block
+// lasts (sim). Under oss -I a block is an I/O request instead.
+#define BLOCK_PERCENT     20
+#define BLOCK_MIN_NS      1000000LL   // 1 ms
+#define BLOCK_MAX_NS      50000000LL  // 50 ms
+#define PARK_TIMEOUT_NS   100000000LL // re-check the segment generation this often (real)
+
+// Under oss -R: chance per quantum of asking for instances of a random class
+// (at most RES_MAX_ASK at a time) and of giving back all of a held class
+#define RES_REQUEST_PERCENT 15
+#define RES_RELEASE_PERCENT 10
+#define RES_MAX_ASK         3
+
+// Under oss -P: chance per quantum of ending it with a memory reference.
+// Most references fall in a few pages around a locus that moves now and
+// then; some are stores.
+#define MEM_REF_PERCENT   50
+#define MEM_LOCAL_PERCENT 85
+#define MEM_WINDOW_PAGES  4
+#define MEM_MOVE_PERCENT  5
+#define MEM_WRITE_PERCENT 30
+
+// Free-running clock polling (oss -W spin:backoff_max:park_ns): this many
+// polls with a pause hint, then that many pauses between polls doubling up
+// to backoff_max (with a yield once there), and parked on the clock
+// whenever more than park_ns (sim) remain until the next thing to print
+#define POLL_SPIN            100
+#define POLL_BACKOFF_MAX     1024
+#define POLL_PARK_NS         2000000LL    // 2 ms
+#define POLL_PARK_TIMEOUT_NS 10000000LL   // re-check commands at least this often while parked (real)
+#define CLOCK_REPICK_EVERY   1024         // loop iterations between clock line lookups (oss -C) and
+                                          // generation checks, power of 2
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined( __aarch64__ )
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+struct PollState {
+    int spin;
+    int backoff_max;
+    long long park_ns;
+    long long deadline_ns;  // what the current approach is for
+    int polls;              // polls in this approach
+    int backoff;            // pauses between polls now
+    int woke;               // just back from parking: read the real clock, a replica may not have the wake yet
+};
+
+// Wait a little before the next clock read. A new deadline (the end, or
+// the next second to report) starts the approach over.
+static void poll_wait(struct PollState *ps, struct SharedSegment *segment, const struct DoorbellReader *reader,
+                      long long now_ns, long long deadline_ns) {
+    if (deadline_ns != ps->deadline_ns) {
+        ps->deadline_ns = deadline_ns;
+        ps->polls = ps->backoff = 0;
+    }
+    if (ps->park_ns > 0 && deadline_ns - now_ns > ps->park_ns) {
+        // A command posted meanwhile (the doorbell moved) cuts the park short
+        clock_park(&segment->clock, deadline_ns - ps->park_ns, POLL_PARK_TIMEOUT_NS, &segment->doorbell,
+                   reader->seen_doorbell);
+        ps->woke = 1;
+        return;
+    }
+    if (ps->polls < ps->spin) {
+        ps->polls++;
+        cpu_relax();
+        return;
+    }
+    for (int i = 0; i < ps->backoff; i++) cpu_relax();
+    if (ps->backoff < ps->backoff_max) {
+        ps->backoff = ps->backoff ? ps->backoff * 2 : 1;
+    } else if (ps->backoff_max > 0) {
+        sched_yield();
+    }
+}
+
+/*
+ * Scheduled mode (oss -m): sleep until oss dispatches a quantum, decide
+ * how much of it we use, reply, repeat. sec/nano to live is our total
+ * CPU demand; once it is served we exit inside the quantum.
+ */
+static void run_scheduled(struct SharedSegment *segment, volatile struct WorkerCounters *ctr, int slot,
+                          struct DoorbellReader *reader, unsigned long long generation, long long demand_ns,
+                          int end_sec, int end_nano) {
+    const struct SysClock *sys_clock = &segment->clock;
+    unsigned int seed = (unsigned int)getpid();
+    long long served_ns = 0;
+
+    // oss -R: what we hold of each class, and the request oss has not granted
+    // yet (being dispatched again means it was)
+    int res_classes = 0, res_instances = 0;
+    const char *res_env = getenv(RES_ENV);
+    if (res_env && sscanf(res_env, "%d:%d", &res_classes, &res_instances) != 2) res_classes = 0;
+    if (res_classes > RES_MAX_CLASSES) res_classes = RES_MAX_CLASSES;
+    int held[RES_MAX_CLASSES] = { 0 };
+    int pending_class = -1, pending_count = 0;
+
+    // oss -P: size of our address space in pages, and the page size
+    int mem_pages = 0, mem_shift = 0, locus = 0;
+    const char *mem_env = getenv(PAGER_ENV);
+    if (mem_env && sscanf(mem_env, "%d:%d", &mem_pages, &mem_shift) != 2) mem_pages = 0;
+    if (mem_shift < 0 || mem_shift > 31) mem_pages = 0;
+
+    // oss -I: devices to send I/O to, and how many cylinders each has
+    int io_devices = 0, io_cylinders = 0;
+    const char *io_env = getenv(IODEV_ENV);
+    if (io_env && (sscanf(io_env, "%d:%d", &io_devices, &io_cylinders) != 2 || io_cylinders < 1)) io_devices = 0;
+
+    while (segment_generation(segment) == generation) {
+        long long arg = 0;
+        int command   = doorbell_wait(reader, segment, slot, &arg, PARK_TIMEOUT_NS);
+        if (command == CMD_NONE) continue;
+        ctr->ack_seq = reader->seen_seq;
+
+        int current_s, current_ns;
+        read_clock(sys_clock, &current_s, &current_ns);
+        ctr->clock_reads++;
+        long long now_ns = (long long)current_s * 1000000000LL + current_ns;
+
+        if (command == CMD_TERMINATE) {
+            const long long end_args[] = { end_sec, end_nano };
+            trace_event(TRACE_WORKER_STOPPED, slot, now_ns, end_args, 2);
+            return;
+        } else if (command == CMD_REPORT) {
+            const long long report_args[] = { end_sec, end_nano, (long long)ctr->clock_reads };
+            trace_event(TRACE_WORKER_REPORT, slot, now_ns, report_args, 3);
+            continue;
+        } else if (command != CMD_DISPATCH) {
+            continue;
+        }
+
+        ctr->loop_iterations++;
+        if (pending_class >= 0) {
+            held[pending_class] += pending_count;
+            pending_class = -1;
+        }
+        long long quantum   = arg > 0 ? arg : 1;
+        long long remaining = demand_ns - served_ns;
+        if (remaining <= quantum) {
+            ctr->overshoot_ns = 0;
+            ctr->done         = 1;
+            post_dispatch_reply(segment, slot, DISPATCH_EXITED, remaining, 0);
+            trace_event(TRACE_WORKER_TERMINATE, slot, now_ns + remaining, NULL, 0);
+            return;
+        }
+        if (res_classes > 0) {
+            // oss takes back whatever we still hold when we exit
+            int roll       = rand_r(&seed) % 100;
+            long long used = quantum > 1 ? 1 + (long long)rand_r(&seed) % (quantum - 1) : quantum;
+            if (roll < RES_REQUEST_PERCENT) {
+                int r    = rand_r(&seed) % res_classes;
+                int room = res_instances - held[r];
+                if (room > 0) {
+                    int n = 1 + rand_r(&seed) % (room < RES_MAX_ASK ? room : RES_MAX_ASK);
+                    served_ns += used;
+                    pending_class = r;
+                    pending_count = n;
+                    post_resource_reply(segment, slot, DISPATCH_REQUEST, used, r, n);
+                    continue;
+                }
+            } else if (roll < RES_REQUEST_PERCENT + RES_RELEASE_PERCENT) {
+                int start = rand_r(&seed) % res_classes, released = 0;
+                for (int i = 0; i < res_classes && !released; i++) {
+                    int r = (start + i) % res_classes;
+                    if (held[r] == 0) continue;
+                    served_ns += used;
+                    post_resource_reply(segment, slot, DISPATCH_RELEASE, used, r, held[r]);
+                    held[r]  = 0;
+                    released = 1;
+                }
+                if (released) continue;
+            }
+        }
+        if (mem_pages > 0 && rand_r(&seed) % 100 < MEM_REF_PERCENT) {
+            // oss dispatches us again once the page is in
+            long long used = quantum > 1 ? 1 + (long long)rand_r(&seed) % (quantum - 1) : quantum;
+            if (rand_r(&seed) % 100 < MEM_MOVE_PERCENT) locus = rand_r(&seed) % mem_pages;
+            int page = rand_r(&seed) % mem_pages;
+            if (rand_r(&seed) % 100 < MEM_LOCAL_PERCENT) page = (locus + rand_r(&seed) % MEM_WINDOW_PAGES) % mem_pages;
+            unsigned int offset = (unsigned int)rand_r(&seed) & ((1u << mem_shift) - 1);
+            served_ns += used;
+            post_memory_reply(segment, slot, used, (unsigned int)page << mem_shift | offset,
+                              rand_r(&seed) % 100 < MEM_WRITE_PERCENT);
+            continue;
+        }
+        if (quantum > 1 && rand_r(&seed) % 100 < BLOCK_PERCENT) {
+            long long used = 1 + (long long)rand_r(&seed) % (quantum - 1);
+            served_ns += used;
+            if (io_devices > 0) {
+                post_io_reply(segment, slot, used, rand_r(&seed) % io_devices, rand_r(&seed) % io_cylinders);
+            } else {
+                long long block = BLOCK_MIN_NS + (long long)rand_r(&seed) % (BLOCK_MAX_NS - BLOCK_MIN_NS);
+                post_dispatch_reply(segment, slot, DISPATCH_BLOCKED, used, block);
+            }
+        } else {
+            served_ns += quantum;
+            post_dispatch_reply(segment, slot, DISPATCH_PREEMPTED, quantum, 0);
+        }
+    }
+    trace_event(TRACE_WORKER_RECLAIMED, slot, 0, NULL, 0);
+}
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: worker <sec_to_live> <nano_to_live>\n");
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: worker <sec_to_live> <nano_to_live> [pcb_slot]\n");
         return 1;
     }
 
     // parse
     int sec_to_live  = atoi(argv[1]);
     int nano_to_live = atoi(argv[2]);
+    int slot         = (argc == 4) ? atoi(argv[3]) : -1;
+
+    // Output goes through the event log (binary if oss was started with -T)
+    trace_open_from_env();
+
+    // oss -o hands us a private pipe as stdout; flush per line so each
+    // chunk oss tags and merges holds whole lines
+    struct stat out_st;
+    if (fstat(STDOUT_FILENO, &out_st) == 0 && S_ISFIFO(out_st.st_mode)) {
+        setvbuf(stdout, NULL, _IOLBF, 0);
+    }
 
     // Setup shared memory system for the child as well (open semaphore)
     init_shared_memory_system();
 
-    // Attach to the existing SysClock in read-only mode
-    int shmid = create_shared_memory(SHM_KEY, sizeof(struct SysClock));
-    const struct SysClock *sys_clock =
-        (const struct SysClock *)attach_shared_memory_ro(shmid);
-    if (!sys_clock) {
+    // Attach to the existing segment. The clock is only ever read; the
+    // mapping is writable so we can fill in our own counter block.
+    int shmid = create_shared_memory(SHM_KEY, sizeof(struct SharedSegment));
+    struct SharedSegment *segment = (struct SharedSegment *)attach_shared_memory_rw(shmid);
+    if (!segment) {
         perror("worker attach");
         return 1;
     }
+    const struct SysClock *sys_clock = &segment->clock;
+
+    // Our private counter block (a local scratch one when run by hand).
+    // Volatile so every update is a real store oss can observe.
+    struct WorkerCounters scratch = { 0 };
+    volatile struct WorkerCounters *ctr =
+        (slot >= 0 && slot < MAX_PROCESSES) ? &segment->counters[slot] : &scratch;
+    ctr->pid            = getpid();
+    ctr->attach_real_ns = monotonic_ns();
+
+    // If a new oss reclaims the segment (ours died), the generation changes
+    unsigned long long generation = segment_generation(segment);
 
     // current time
-    int start_sec  = sys_clock->sec;
-    int start_nano = sys_clock->nano;
+    int start_sec, start_nano;
+    segment_read_clock(segment, sys_clock, &start_sec, &start_nano);
+    ctr->clock_reads++;
 
     // compute target
     int end_sec  = start_sec  + sec_to_live;
@@ -100,35 +339,122 @@ int main(int argc, char *argv[]) {
     }
 
     // Print start message
-    printf("WORKER PID:%d Start: %d s, %d ns -> End: %d s, %d ns\n",
-           getpid(), start_sec, start_nano, end_sec, end_nano);
+    const long long start_args[] = { end_sec, end_nano };
+    trace_event(TRACE_WORKER_START, slot, (long long)start_sec * 1000000000LL + start_nano, start_args, 2);
 
     int last_reported_sec = start_sec;
 
-    // loop until time >= end_time
-    while (1) {
-        int current_s  = sys_clock->sec;
-        int current_ns = sys_clock->nano;
+    // oss -W: how to wait between clock reads (defaults above)
+    struct PollState poll = { POLL_SPIN, POLL_BACKOFF_MAX, POLL_PARK_NS, -1, 0, 0, 0 };
+    const char *poll_env = getenv(POLL_ENV);
+    if (poll_env && sscanf(poll_env, "%d:%d:%lld", &poll.spin, &poll.backoff_max, &poll.park_ns) != 3) {
+        poll.spin        = POLL_SPIN;
+        poll.backoff_max = POLL_BACKOFF_MAX;
+        poll.park_ns     = POLL_PARK_NS;
+    }
+
+    // Commands from oss arrive through our channel (doorbell.h)
+    struct DoorbellReader reader;
+    doorbell_reader_init(&reader, segment);
+
+    // oss -e: count our own poll loop and nothing else
+    struct PerfCounters perf;
+    int perf_on = perf_counters_requested() && perf_counters_open(&perf) > 0;
+    if (perf_on) perf_counters_enable(&perf);
+
+    const char *sched_env = getenv(SCHED_ENV);
+    int scheduled         = sched_env && *sched_env == '1';
+    if (scheduled) {
+        run_scheduled(segment, ctr, slot, &reader, generation,
+                      (long long)sec_to_live * 1000000000LL + nano_to_live, end_sec, end_nano);
+    }
+
+    // loop until time >= end_time (free-running workers only)
+    const struct SysClock *local_clock = sys_clock;
+    while (!scheduled) {
+        // A reclaim is rare, so look for one now and then and after every park
+        // rather than loading the header on each poll
+        if (((ctr->loop_iterations & (CLOCK_REPICK_EVERY - 1)) == 0 || poll.woke) &&
+            segment_generation(segment) != generation) {
+            trace_event(TRACE_WORKER_RECLAIMED, slot, 0, NULL, 0);
+            break;
+        }
+
+        // Consistent sec/nano pair even if oss is mid-increment, from the
+        // clock line of the domain we run on (oss -C); we may migrate, so
+        // look the line up again now and then
+        if ((ctr->loop_iterations & (CLOCK_REPICK_EVERY - 1)) == 0) local_clock = segment_local_clock(segment);
+        int current_s, current_ns;
+        segment_read_clock(segment, poll.woke ? sys_clock : local_clock, &current_s, &current_ns);
+        poll.woke = 0;
+        ctr->clock_reads++;
+        ctr->loop_iterations++;
+        long long now_ns = (long long)current_s * 1000000000LL + current_ns;
+
+        long long arg = 0;
+        int command   = doorbell_poll(&reader, segment, slot, &arg);
+        if (command != CMD_NONE) {
+            ctr->ack_seq = reader.seen_seq;
+            if (command == CMD_TERMINATE) {
+                const long long end_args[] = { end_sec, end_nano };
+                trace_event(TRACE_WORKER_STOPPED, slot, now_ns, end_args, 2);
+                break;
+            } else if (command == CMD_REPORT) {
+                const long long report_args[] = { end_sec, end_nano, (long long)ctr->clock_reads };
+                trace_event(TRACE_WORKER_REPORT, slot, now_ns, report_args, 3);
+            }
+        }
 
         // if we've reached or passed the target time, break
         if (current_s > end_sec ||
             (current_s == end_sec && current_ns >= end_nano)) {
-            printf("WORKER PID:%d terminating at %d s, %d ns\n",
-                   getpid(), current_s, current_ns);
+            ctr->overshoot_ns = (long long)(current_s - end_sec) * 1000000000LL + (current_ns - end_nano);
+            ctr->done         = 1;
+            trace_event(TRACE_WORKER_TERMINATE, slot, now_ns, NULL, 0);
             break;
         }
 
         // every time we cross a new second, output a quick message
         if (current_s > last_reported_sec) {
-            printf("WORKER PID:%d alive for %d seconds\n",
-                   getpid(), (current_s - start_sec));
+            const long long alive_args[] = { current_s - start_sec };
+            trace_event(TRACE_WORKER_ALIVE, slot, now_ns, alive_args, 1);
             last_reported_sec = current_s;
         }
+
+        long long end_ns  = (long long)end_sec * 1000000000LL + end_nano;
+        long long next_ns = (long long)(last_reported_sec + 1) * 1000000000LL;
+        poll_wait(&poll, segment, &reader, now_ns, end_ns < next_ns ? end_ns : next_ns);
+    }
+
+    if (perf_on) {
+        perf_counters_disable(&perf);
+        struct PerfSample sample;
+        perf_counters_read(&perf, &sample);
+        perf_counters_close(&perf);
+        const long long perf_args[] = {
+            PERF_SCOPE_WORKER,
+            1,
+            sample.values[PERF_CYCLES],
+            sample.values[PERF_INSTRUCTIONS],
+            sample.values[PERF_CACHE_MISSES],
+            sample.values[PERF_CONTEXT_SWITCHES],
+            sample.values[PERF_TASK_CLOCK],
+        };
+        int sec, nano;
+        segment_read_clock(segment, sys_clock, &sec, &nano);
+        trace_event(TRACE_PERF, slot, (long long)sec * 1000000000LL + nano, perf_args, 7);
+        if (slot >= 0 && slot < MAX_PROCESSES && segment_generation(segment) == generation) {
+            segment->perf[slot] = sample;
+        }
     }
 
-    // cleanup
-    detach_shared_memory((void *)sys_clock);
+    // cleanup; oss times the reap from here (unless the segment changed hands)
+    if (segment_generation(segment) == generation) {
+        ctr->exit_real_ns = monotonic_ns();
+    }
+    detach_shared_memory((void *)segment);
     cleanup_shared_memory_system();
+    trace_close();
 
     return 0;
 }
@@ -0,0 +1,173 @@
+// workerlog.c
+
+#define _GNU_SOURCE
+#include "workerlog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define MERGER_EVENTS 64
+
+struct WorkerPipe {
+    int fd;
+    int slot;
+    pid_t pid;
+};
+
+static int log_fd   = -1;
+static int epoll_fd = -1;
+static int stop_fd  = -1;  // eventfd, readable once worker_log_stop() is called
+
+static int open_pipes = 0;  // registered and not yet at EOF (atomic)
+static pthread_t merger_thread;
+
+// Move exactly 'len' bytes from the pipe to the log, without copying if we can
+static void move_bytes(int from, size_t len) {
+    while (len > 0) {
+        ssize_t n = splice(from, NULL, log_fd, NULL, len, SPLICE_F_MOVE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EINVAL) {
+            // Log on a filesystem without splice support: fall back to copying
+            char buf[4096];
+            n = read(from, buf, len < sizeof(buf) ? len : sizeof(buf));
+            if (n > 0 && write(log_fd, buf, (size_t)n) != n) n = -1;
+        }
+        if (n <= 0) {
+            if (n < 0) perror("worker log splice");
+            return;
+        }
+        len -= (size_t)n;
+    }
+}
+
+// Tag and move everything currently buffered in one worker's pipe
+static void drain_pipe(const struct WorkerPipe *wp) {
+    int avail = 0;
+    if (ioctl(wp->fd, FIONREAD, &avail) == -1 || avail <= 0) return;
+
+    char tag[96];
+    int len = snprintf(tag, sizeof(tag), "== slot %d pid %d bytes %d ==\n", wp->slot, (int)wp->pid, avail);
+    if (write(log_fd, tag, (size_t)len) != len) {
+        perror("worker log tag");
+    }
+    move_bytes(wp->fd, (size_t)avail);
+}
+
+static void *merger_main(void *unused) {
+    (void)unused;
+    struct epoll_event events[MERGER_EVENTS];
+    int stopping = 0;
+
+    while (!stopping || __atomic_load_n(&open_pipes, __ATOMIC_ACQUIRE) > 0) {
+        int n = epoll_wait(epoll_fd, events, MERGER_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait worker log");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            struct WorkerPipe *wp = events[i].data.ptr;
+            if (!wp) {
+                // The stop eventfd; keep going until every pipe hits EOF
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, stop_fd, NULL);
+                stopping = 1;
+                continue;
+            }
+            drain_pipe(wp);
+            if ((events[i].events & (EPOLLHUP | EPOLLERR)) && !(events[i].events & EPOLLIN)) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, wp->fd, NULL);
+                close(wp->fd);
+                free(wp);
+                __atomic_sub_fetch(&open_pipes, 1, __ATOMIC_RELEASE);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Undo a partial worker_log_start(): worker_log_enabled() must stay false
+static void close_fds(void) {
+    if (stop_fd != -1) close(stop_fd);
+    if (epoll_fd != -1) close(epoll_fd);
+    if (log_fd != -1) close(log_fd);
+    stop_fd  = -1;
+    epoll_fd = -1;
+    log_fd   = -1;
+}
+
+int worker_log_start(const char *path) {
+    log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log_fd == -1) {
+        perror("worker log open");
+        return -1;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    stop_fd  = eventfd(0, EFD_CLOEXEC);
+    if (epoll_fd == -1 || stop_fd == -1) {
+        perror("worker log epoll/eventfd");
+        close_fds();
+        return -1;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &ev) == -1) {
+        perror("epoll_ctl worker log stop");
+        close_fds();
+        return -1;
+    }
+
+    if (pthread_create(&merger_thread, NULL, merger_main, NULL) != 0) {
+        perror("pthread_create worker log");
+        close_fds();
+        return -1;
+    }
+    return 0;
+}
+
+int worker_log_enabled(void) {
+    return log_fd != -1;
+}
+
+int worker_log_pipe(int fds[2]) {
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        perror("pipe2 worker log");
+        return -1;
+    }
+    return 0;
+}
+
+void worker_log_attach(int read_fd, int slot, pid_t pid) {
+    struct WorkerPipe *wp = malloc(sizeof(*wp));
+    if (!wp) {
+        close(read_fd);
+        return;
+    }
+    wp->fd   = read_fd;
+    wp->slot = slot;
+    wp->pid  = pid;
+
+    // Level-triggered: a chunk that arrives while we drain is picked up next round
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = wp };
+    __atomic_add_fetch(&open_pipes, 1, __ATOMIC_RELEASE);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, read_fd, &ev) == -1) {
+        perror("epoll_ctl worker log");
+        __atomic_sub_fetch(&open_pipes, 1, __ATOMIC_RELEASE);
+        close(read_fd);
+        free(wp);
+    }
+}
+
+void worker_log_stop(void) {
+    if (log_fd == -1) return;
+    unsigned long long one = 1;
+    if (write(stop_fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        perror("worker log stop");
+    }
+    pthread_join(merger_thread, NULL);
+    close_fds();
+}
@@ -0,0 +1,34 @@
+// workerlog.h
+
+#ifndef WORKERLOG_H
+#define WORKERLOG_H
+
+#include <sys/types.h>
+
+/*
+ * Per-worker stdout capture (oss -o). Every worker gets its own pipe as
+ * stdout; a merger thread in oss waits on all of them with epoll and
+ * moves whatever is buffered in a pipe into one log file with splice(),
+ * so the bytes never pass through user space. Each chunk is preceded by
+ * a one-line tag naming the worker:
+ *
+ *   == slot 3 pid 4242 bytes 87 ==
+ *   <87 bytes of that worker's output>
+ */
+
+// Create the log file and start the merger thread. Returns 0 or -1.
+int worker_log_start( const char *path );
+
+// 1 if workers should be given a pipe
+int worker_log_enabled( void );
+
+// Create a worker's pipe before fork: fds[0] read end (oss), fds[1] write end (worker stdout)
+int worker_log_pipe( int fds[2] );
+
+// After fork: hand the read end to the merger (the write end must already be closed)
+void worker_log_attach( int read_fd, int slot, pid_t pid );
+
+// Drain every pipe until its worker has exited, then stop the merger
+void worker_log_stop( void );
+
+#endif /* WORKERLOG_H */
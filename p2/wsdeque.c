@@ -0,0 +1,60 @@
+// wsdeque.c
+
+#include "wsdeque.h"
+#include "segment.h"
+
+_Static_assert(WSDEQUE_CAPACITY > MAX_PROCESSES, "a deque must hold every PCB slot");
+_Static_assert((WSDEQUE_CAPACITY & (WSDEQUE_CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+void wsdeque_init(struct WsDeque *d) {
+    d->top    = 0;
+    d->bottom = 0;
+}
+
+void wsdeque_push(struct WsDeque *d, int item) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    __atomic_store_n(&d->items[b & (WSDEQUE_CAPACITY - 1)], item, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+int wsdeque_pop(struct WsDeque *d) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+    int item = WSDEQUE_EMPTY;
+    if (t <= b) {
+        item = __atomic_load_n(&d->items[b & (WSDEQUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+        if (t == b) {
+            // Last item: race the thieves for it through top
+            if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                item = WSDEQUE_EMPTY;
+            }
+            __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return item;
+}
+
+int wsdeque_steal(struct WsDeque *d) {
+    long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return WSDEQUE_EMPTY;
+
+    int item = __atomic_load_n(&d->items[t & (WSDEQUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return WSDEQUE_ABORT;
+    }
+    return item;
+}
+
+long wsdeque_size(const struct WsDeque *d) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    return b > t ? b - t : 0;
+}
@@ -0,0 +1,40 @@
+// wsdeque.h
+
+#ifndef WSDEQUE_H
+#define WSDEQUE_H
+
+/*
+ * Chase-Lev work-stealing deque of PCB slot numbers (Chase & Lev 2005,
+ * with the C11 orderings of Le et al. 2013). The owning thread pushes
+ * and pops at the bottom without atomic read-modify-writes. Any thread
+ * may steal from the top with one CAS, and only the owner and thieves
+ * racing for the last item ever contend. A slot sits in at most one
+ * deque at a time, so a fixed buffer larger than MAX_PROCESSES never
+ * overflows and the deque never grows.
+ */
+
+#define WSDEQUE_CAPACITY 32  // power of two, > MAX_PROCESSES
+#define WSDEQUE_EMPTY    ( -1 )
+#define WSDEQUE_ABORT    ( -2 )  // lost a race with another thief; try again
+
+struct WsDeque {
+  _Alignas( 64 ) long top;     // next item to steal; thieves CAS it
+  _Alignas( 64 ) long bottom;  // next free cell; written by the owner only
+  int items[WSDEQUE_CAPACITY];
+};
+
+void wsdeque_init( struct WsDeque *d );
+
+// Owner: add an item at the bottom
+void wsdeque_push( struct WsDeque *d, int item );
+
+// Owner: take the newest item, or WSDEQUE_EMPTY
+int wsdeque_pop( struct WsDeque *d );
+
+// Any thread: take the oldest item, WSDEQUE_EMPTY or WSDEQUE_ABORT
+int wsdeque_steal( struct WsDeque *d );
+
+// Racy size, for heuristics only
+long wsdeque_size( const struct WsDeque *d );
+
+#endif /* WSDEQUE_H */
@@ -0,0 +1,476 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "evcal.h"
+#include "hist.h"
+#include "pager.h"
+#include "resmgr.h"
+#include "spscq.h"
+#include "trace.h"
+#include "tracetext.h"
+#include "unity.h"
+#include "wsdeque.h"
+
+void setUp( void ) {}
+
+void tearDown( void ) {}
+
+// ---- evcal ----
+
+void test_calendar_PopsInTimeOrder( void ) {
+  struct EventCalendar cal;
+  calendar_init( &cal );
+  const long long times[] = { 50, 10, 40, 30, 20, 60, 5 };
+  int n                   = (int)( sizeof( times ) / sizeof( times[0] ) );
+  for ( int i = 0; i < n; i++ ) {
+    calendar_push( &cal, times[i], EV_WAKEUP, i, 0, 0 );
+  }
+  TEST_ASSERT_EQUAL_INT64( 5, calendar_peek( &cal )->time_ns );
+
+  struct CalendarEvent ev;
+  long long last = -1;
+  for ( int i = 0; i < n; i++ ) {
+    TEST_ASSERT_EQUAL_INT( 1, calendar_pop_due( &cal, 1000, &ev ) );
+    TEST_ASSERT_GREATER_OR_EQUAL_INT64( last, ev.time_ns );
+    last = ev.time_ns;
+  }
+  TEST_ASSERT_NULL( calendar_peek( &cal ) );
+  calendar_free( &cal );
+}
+
+void test_calendar_TiesPopFifo( void ) {
+  struct EventCalendar cal;
+  calendar_init( &cal );
+  for ( int i = 0; i < 20; i++ ) {
+    calendar_push( &cal, 100, EV_WAKEUP, i, 0, 0 );
+  }
+  struct CalendarEvent ev;
+  for ( int i = 0; i < 20; i++ ) {
+    TEST_ASSERT_EQUAL_INT( 1, calendar_pop_due( &cal, 100, &ev ) );
+    TEST_ASSERT_EQUAL_INT( i, ev.slot );
+  }
+  calendar_free( &cal );
+}
+
+void test_calendar_KeepsFutureEvents( void ) {
+  struct EventCalendar cal;
+  calendar_init( &cal );
+  calendar_push( &cal, 200, EV_IO_COMPLETE, 1, 7, 3 );
+  calendar_push( &cal, 100, EV_WAKEUP, 0, 0, 0 );
+
+  struct CalendarEvent ev;
+  TEST_ASSERT_EQUAL_INT( 0, calendar_pop_due( &cal, 99, &ev ) );
+  TEST_ASSERT_EQUAL_INT( 1, calendar_pop_due( &cal, 150, &ev ) );
+  TEST_ASSERT_EQUAL_INT( 0, ev.slot );
+  TEST_ASSERT_EQUAL_INT( 0, calendar_pop_due( &cal, 150, &ev ) );
+  TEST_ASSERT_EQUAL_INT( 1, calendar_pop_due( &cal, 200, &ev ) );
+  TEST_ASSERT_EQUAL_INT( EV_IO_COMPLETE, ev.type );
+  TEST_ASSERT_EQUAL_INT( 7, (int)ev.token );
+  TEST_ASSERT_EQUAL_INT64( 3, ev.arg );
+  calendar_free( &cal );
+}
+
+// ---- hist ----
+
+void test_hist_SmallValuesAreExact( void ) {
+  struct LatencyHist h;
+  memset( &h, 0, sizeof( h ) );
+  for ( int v = 0; v < HIST_SUB_BUCKETS; v++ ) {
+    hist_record( &h, v );
+  }
+  TEST_ASSERT_EQUAL_INT64( 0, h.min );
+  TEST_ASSERT_EQUAL_INT64( HIST_SUB_BUCKETS - 1, h.max );
+  TEST_ASSERT_EQUAL_INT64( HIST_SUB_BUCKETS / 2 - 1, hist_percentile( &h, 50 ) );
+  TEST_ASSERT_EQUAL_INT64( HIST_SUB_BUCKETS - 1, hist_percentile( &h, 100 ) );
+}
+
+void test_hist_BucketWidthIsBounded( void ) {
+  // With a larger sample to keep max out of the way, p50 of two samples
+  // is the upper edge of the smaller one's bucket
+  for ( long long v = HIST_SUB_BUCKETS; v < ( 1LL << 60 ); v = v * 3 + 1 ) {
+    struct LatencyHist h;
+    memset( &h, 0, sizeof( h ) );
+    hist_record( &h, v );
+    hist_record( &h, LLONG_MAX );
+    long long upper = hist_percentile( &h, 50 );
+    TEST_ASSERT_GREATER_OR_EQUAL_INT64( v, upper );
+    TEST_ASSERT_LESS_OR_EQUAL_INT64( v + v / HIST_SUB_BUCKETS, upper );
+  }
+}
+
+void test_hist_PercentileCappedAtMax( void ) {
+  struct LatencyHist h;
+  memset( &h, 0, sizeof( h ) );
+  TEST_ASSERT_EQUAL_INT64( 0, hist_percentile( &h, 99 ) );
+  hist_record( &h, -5 );
+  hist_record( &h, 1000 );
+  TEST_ASSERT_EQUAL_INT64( 0, h.min );
+  TEST_ASSERT_EQUAL_INT64( 1000, hist_percentile( &h, 100 ) );
+  TEST_ASSERT_EQUAL_UINT64( 2, h.count );
+}
+
+// ---- wsdeque ----
+
+void test_wsdeque_PopIsLifoStealIsFifo( void ) {
+  struct WsDeque d;
+  wsdeque_init( &d );
+  for ( int i = 0; i < 5; i++ ) {
+    wsdeque_push( &d, i );
+  }
+  TEST_ASSERT_EQUAL_INT( 4, wsdeque_pop( &d ) );
+  TEST_ASSERT_EQUAL_INT( 0, wsdeque_steal( &d ) );
+  TEST_ASSERT_EQUAL_INT( 3, wsdeque_pop( &d ) );
+  TEST_ASSERT_EQUAL_INT( 1, wsdeque_steal( &d ) );
+  TEST_ASSERT_EQUAL_INT( 2, wsdeque_pop( &d ) );
+  TEST_ASSERT_EQUAL_INT( WSDEQUE_EMPTY, wsdeque_pop( &d ) );
+  TEST_ASSERT_EQUAL_INT( WSDEQUE_EMPTY, wsdeque_steal( &d ) );
+}
+
+#define RACE_ITEMS   200000
+#define RACE_THIEVES 3
+
+struct RaceState {
+  struct WsDeque deque;
+  unsigned char taken[RACE_ITEMS];
+  int done;
+  int duplicates;
+};
+
+static void take( struct RaceState *rs, int item ) {
+  if ( __atomic_exchange_n( &rs->taken[item], 1, __ATOMIC_RELAXED ) ) {
+    __atomic_add_fetch( &rs->duplicates, 1, __ATOMIC_RELAXED );
+  }
+}
+
+static void *thief( void *arg ) {
+  struct RaceState *rs = arg;
+  while ( 1 ) {
+    int item = wsdeque_steal( &rs->deque );
+    if ( item >= 0 ) {
+      take( rs, item );
+    } else if ( item == WSDEQUE_EMPTY && __atomic_load_n( &rs->done, __ATOMIC_ACQUIRE ) ) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+void test_wsdeque_StealPopRaceTakesEachItemOnce( void ) {
+  // The deque wants its 64-byte alignment, which calloc does not promise
+  struct RaceState *rs = aligned_alloc( 64, sizeof( *rs ) );
+  TEST_ASSERT_NOT_NULL( rs );
+  memset( rs, 0, sizeof( *rs ) );
+  wsdeque_init( &rs->deque );
+  pthread_t thieves[RACE_THIEVES];
+  for ( int i = 0; i < RACE_THIEVES; i++ ) {
+    pthread_create( &thieves[i], NULL, thief, rs );
+  }
+
+  // Keep the deque short so the owner and the thieves keep meeting at the
+  // last item, and never past its fixed capacity
+  int next = 0;
+  while ( next < RACE_ITEMS ) {
+    while ( next < RACE_ITEMS && wsdeque_size( &rs->deque ) < 4 ) {
+      wsdeque_push( &rs->deque, next++ );
+    }
+    int item = wsdeque_pop( &rs->deque );
+    if ( item >= 0 ) take( rs, item );
+  }
+  int item;
+  while ( ( item = wsdeque_pop( &rs->deque ) ) != WSDEQUE_EMPTY ) {
+    take( rs, item );
+  }
+  __atomic_store_n( &rs->done, 1, __ATOMIC_RELEASE );
+  for ( int i = 0; i < RACE_THIEVES; i++ ) {
+    pthread_join( thieves[i], NULL );
+  }
+
+  int missing = 0;
+  for ( int i = 0; i < RACE_ITEMS; i++ ) {
+    if ( !rs->taken[i] ) missing++;
+  }
+  int duplicates = rs->duplicates;
+  free( rs );
+  TEST_ASSERT_EQUAL_INT( 0, duplicates );
+  TEST_ASSERT_EQUAL_INT( 0, missing );
+}
+
+// ---- spscq ----
+
+void test_spsc_FullAndEmpty( void ) {
+  struct SpscQueue q;
+  TEST_ASSERT_EQUAL_INT( -1, spsc_init( &q, 3, sizeof( int ) ) );
+  TEST_ASSERT_EQUAL_INT( 0, spsc_init( &q, 4, sizeof( int ) ) );
+  int v;
+  TEST_ASSERT_EQUAL_INT( 0, spsc_pop( &q, &v ) );
+  for ( int i = 0; i < 4; i++ ) {
+    TEST_ASSERT_EQUAL_INT( 1, spsc_push( &q, &i ) );
+  }
+  TEST_ASSERT_EQUAL_INT( 0, spsc_push( &q, &v ) );
+  TEST_ASSERT_EQUAL_INT( 1, spsc_pop( &q, &v ) );
+  TEST_ASSERT_EQUAL_INT( 0, v );
+  spsc_free( &q );
+}
+
+void test_spsc_IndexWrapAround( void ) {
+  struct SpscQueue q;
+  TEST_ASSERT_EQUAL_INT( 0, spsc_init( &q, 4, sizeof( int ) ) );
+  // Start just below the unsigned wrap so head and tail overflow mid-test
+  q.head = q.tail = UINT_MAX - 5;
+  int expect = 0, next = 0, v;
+  for ( int round = 0; round < 10; round++ ) {
+    for ( int i = 0; i < 3; i++, next++ ) {
+      TEST_ASSERT_EQUAL_INT( 1, spsc_push( &q, &next ) );
+    }
+    for ( int i = 0; i < 3; i++, expect++ ) {
+      TEST_ASSERT_EQUAL_INT( 1, spsc_pop( &q, &v ) );
+      TEST_ASSERT_EQUAL_INT( expect, v );
+    }
+  }
+  TEST_ASSERT_EQUAL_INT( 0, spsc_pop( &q, &v ) );
+  for ( int i = 0; i < 4; i++ ) {
+    TEST_ASSERT_EQUAL_INT( 1, spsc_push( &q, &i ) );
+  }
+  TEST_ASSERT_EQUAL_INT( 0, spsc_push( &q, &v ) );
+  spsc_free( &q );
+}
+
+#define SPSC_MESSAGES 20000
+
+static void *spsc_producer( void *arg ) {
+  struct SpscQueue *q = arg;
+  for ( long long i = 0; i < SPSC_MESSAGES; i++ ) {
+    spsc_push_wait( q, &i );
+  }
+  return NULL;
+}
+
+void test_spsc_ThreadedOrder( void ) {
+  struct SpscQueue q;
+  TEST_ASSERT_EQUAL_INT( 0, spsc_init( &q, 16, sizeof( long long ) ) );
+  pthread_t producer;
+  pthread_create( &producer, NULL, spsc_producer, &q );
+  long long expect = 0, v;
+  int in_order     = 1;
+  while ( expect < SPSC_MESSAGES ) {
+    if ( !spsc_pop( &q, &v ) ) {
+      spsc_wait( &q, NULL, 1000000 );
+      continue;
+    }
+    if ( v != expect ) in_order = 0;
+    expect++;
+  }
+  pthread_join( producer, NULL );
+  spsc_free( &q );
+  TEST_ASSERT_TRUE( in_order );
+}
+
+// ---- resmgr ----
+
+void test_resmgr_DetectsCycle( void ) {
+  struct ResourceManager rm;
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_init( &rm, 2, 1, 3 ) );
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_request( &rm, 0, 0, 1 ) );
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_request( &rm, 1, 1, 1 ) );
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_request( &rm, 0, 1, 1 ) );
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_request( &rm, 1, 0, 1 ) );
+  // Process 2 only waits behind the cycle, but it cannot finish either
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_request( &rm, 2, 0, 1 ) );
+
+  unsigned long long deadlocked[1];
+  int count = resmgr_detect( &rm, deadlocked );
+  TEST_ASSERT_EQUAL_INT( 3, count );
+  TEST_ASSERT_EQUAL_UINT64( 0x7ULL, deadlocked[0] );
+
+  // Killing process 0 frees class 0 for process 1, and 1 then frees 2
+  resmgr_release_all( &rm, 0 );
+  int granted[3];
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_grant_waiting( &rm, granted ) );
+  TEST_ASSERT_EQUAL_INT( 1, granted[0] );
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_detect( &rm, deadlocked ) );
+  resmgr_free( &rm );
+}
+
+void test_resmgr_WaiterBehindRunnerIsNotDeadlocked( void ) {
+  struct ResourceManager rm;
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_init( &rm, 1, 2, 2 ) );
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_request( &rm, 0, 0, 2 ) );
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_request( &rm, 1, 0, 1 ) );
+  TEST_ASSERT_TRUE( resmgr_has_waiting( &rm ) );
+
+  unsigned long long deadlocked[1];
+  TEST_ASSERT_EQUAL_INT( 0, resmgr_detect( &rm, deadlocked ) );
+  TEST_ASSERT_EQUAL_UINT64( 0, deadlocked[0] );
+
+  resmgr_release( &rm, 0, 0, 1 );
+  int granted[2];
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_grant_waiting( &rm, granted ) );
+  TEST_ASSERT_EQUAL_INT( 1, resmgr_held( &rm, 1 ) );
+  TEST_ASSERT_FALSE( resmgr_has_waiting( &rm ) );
+  resmgr_free( &rm );
+}
+
+// ---- pager ----
+
+// One process, page size 1 (address == page number), three frames
+static struct Pager pager_with( int policy ) {
+  struct Pager pg;
+  TEST_ASSERT_EQUAL_INT( 0, pager_init( &pg, policy, 1, 8, 0, 3 ) );
+  return pg;
+}
+
+// Reference a page; returns the victim page of the fault, -1 for a free
+// frame, or -2 for a hit
+static int touch( struct Pager *pg, uint32_t page, int write ) {
+  if ( pager_access( pg, 0, page, write ) ) return -2;
+  struct PageFault pf;
+  pager_fault( pg, 0, page, write, &pf );
+  return pf.victim_page;
+}
+
+void test_pager_FifoEvictsOldestLoad( void ) {
+  struct Pager pg = pager_with( PAGE_FIFO );
+  TEST_ASSERT_EQUAL_INT( -1, touch( &pg, 0, 0 ) );
+  TEST_ASSERT_EQUAL_INT( -1, touch( &pg, 1, 0 ) );
+  TEST_ASSERT_EQUAL_INT( -1, touch( &pg, 2, 0 ) );
+  TEST_ASSERT_EQUAL_INT( -2, touch( &pg, 0, 0 ) );
+  // Recent use does not matter to fifo
+  TEST_ASSERT_EQUAL_INT( 0, touch( &pg, 3, 0 ) );
+  TEST_ASSERT_EQUAL_INT( 1, touch( &pg, 4, 0 ) );
+  TEST_ASSERT_EQUAL_INT( 2, touch( &pg, 0, 0 ) );
+  TEST_ASSERT_EQUAL_UINT64( 3, pg.stats.evictions );
+  pager_free( &pg );
+}
+
+void test_pager_ClockGivesSecondChance( void ) {
+  struct Pager pg = pager_with( PAGE_CLOCK );
+  touch( &pg, 0, 0 );
+  touch( &pg, 1, 0 );
+  touch( &pg, 2, 0 );
+  // Every frame is referenced: the hand clears them all and comes back to 0
+  TEST_ASSERT_EQUAL_INT( 0, touch( &pg, 3, 0 ) );
+  // Page 1 is referenced again, so the hand passes it and takes page 2
+  TEST_ASSERT_EQUAL_INT( -2, touch( &pg, 1, 0 ) );
+  TEST_ASSERT_EQUAL_INT( 2, touch( &pg, 4, 0 ) );
+  TEST_ASSERT_EQUAL_INT( -2, touch( &pg, 1, 0 ) );
+  pager_free( &pg );
+}
+
+void test_pager_LruEvictsLeastRecentlyUsed( void ) {
+  struct Pager pg = pager_with( PAGE_LRU );
+  touch( &pg, 0, 0 );
+  touch( &pg, 1, 1 );
+  touch( &pg, 2, 0 );
+  pager_age( &pg );
+  touch( &pg, 0, 0 );
+  touch( &pg, 2, 0 );
+  pager_age( &pg );
+
+  struct PageFault pf;
+  TEST_ASSERT_EQUAL_INT( 0, pager_access( &pg, 0, 3, 0 ) );
+  pager_fault( &pg, 0, 3, 0, &pf );
+  TEST_ASSERT_EQUAL_INT( 1, pf.victim_page );
+  TEST_ASSERT_EQUAL_INT( 1, pf.writeback );
+  TEST_ASSERT_EQUAL_INT( 3, pager_resident( &pg ) );
+  pager_free( &pg );
+}
+
+// ---- trace file round trip ----
+
+void test_trace_FileRoundTrip( void ) {
+  char path[] = "/tmp/test_p2_traceXXXXXX";
+  int fd      = mkstemp( path );
+  TEST_ASSERT_TRUE( fd >= 0 );
+  close( fd );
+
+  const long long start[] = { 3, 250000000 };
+  const long long row[]   = { 4242, -1, LLONG_MAX, 7, 0 };
+  TEST_ASSERT_EQUAL_INT( 0, trace_create( path ) );
+  trace_event( TRACE_WORKER_START, 2, 1500000000LL, start, 2 );
+  trace_event( TRACE_TABLE_ROW, -1, 0, row, 5 );
+  trace_event( TRACE_TABLE_END, 0, LLONG_MIN, NULL, 0 );
+  trace_close();
+  unsetenv( TRACE_ENV );
+
+  FILE *fp = fopen( path, "rb" );
+  TEST_ASSERT_NOT_NULL( fp );
+  unsigned char buf[TRACE_RECORD_SIZE + TRACE_MAX_ARGS * TRACE_ARG_SIZE];
+  struct TraceFileHeader hdr;
+  TEST_ASSERT_EQUAL_INT( 1, (int)fread( buf, TRACE_HEADER_SIZE, 1, fp ) );
+  TEST_ASSERT_EQUAL_INT( 0, trace_decode_header( buf, &hdr ) );
+  TEST_ASSERT_EQUAL_INT( TRACE_VERSION, (int)hdr.version );
+  TEST_ASSERT_EQUAL_INT( TRACE_RECORD_SIZE, (int)hdr.record_size );
+
+  struct TraceRecord rec;
+  long long args[TRACE_MAX_ARGS];
+  TEST_ASSERT_EQUAL_INT( 1, (int)fread( buf, TRACE_RECORD_SIZE, 1, fp ) );
+  trace_decode_record( buf, &rec );
+  TEST_ASSERT_EQUAL_INT( TRACE_WORKER_START, rec.type );
+  TEST_ASSERT_EQUAL_INT( 2, rec.slot );
+  TEST_ASSERT_EQUAL_INT( (int)getpid(), rec.pid );
+  TEST_ASSERT_EQUAL_INT64( 1500000000LL, rec.sim_ns );
+  TEST_ASSERT_EQUAL_INT( 2, (int)fread( buf, TRACE_ARG_SIZE, rec.argc, fp ) );
+  trace_decode_args( buf, rec.argc, args );
+  char line[TRACE_TEXT_MAX];
+  trace_format_text( line, sizeof( line ), &rec, args );
+  char expect[TRACE_TEXT_MAX];
+  snprintf( expect, sizeof( expect ), "WORKER PID:%d Start: 1 s, 500000000 ns -> End: 3 s, 250000000 ns\n",
+            (int)getpid() );
+  TEST_ASSERT_EQUAL_STRING( expect, line );
+
+  TEST_ASSERT_EQUAL_INT( 1, (int)fread( buf, TRACE_RECORD_SIZE, 1, fp ) );
+  trace_decode_record( buf, &rec );
+  TEST_ASSERT_EQUAL_INT( TRACE_TABLE_ROW, rec.type );
+  TEST_ASSERT_EQUAL_INT( -1, rec.slot );
+  TEST_ASSERT_EQUAL_INT( 5, (int)fread( buf, TRACE_ARG_SIZE, rec.argc, fp ) );
+  trace_decode_args( buf, rec.argc, args );
+  TEST_ASSERT_EQUAL_MEMORY( row, args, sizeof( row ) );
+
+  TEST_ASSERT_EQUAL_INT( 1, (int)fread( buf, TRACE_RECORD_SIZE, 1, fp ) );
+  trace_decode_record( buf, &rec );
+  TEST_ASSERT_EQUAL_INT( TRACE_TABLE_END, rec.type );
+  TEST_ASSERT_EQUAL_INT( 0, rec.argc );
+  TEST_ASSERT_EQUAL_INT64( LLONG_MIN, rec.sim_ns );
+  TEST_ASSERT_EQUAL_INT( 0, (int)fread( buf, 1, 1, fp ) );
+  fclose( fp );
+  unlink( path );
+}
+
+void test_trace_RecordLayoutIsFixed( void ) {
+  const struct TraceRecord rec = { TRACE_DELTA_STATE, 1, -2, 0x01020304, 0x1122334455667788LL, -1 };
+  const long long arg          = 0x0102030405060708LL;
+  unsigned char buf[TRACE_RECORD_SIZE + TRACE_ARG_SIZE];
+  TEST_ASSERT_EQUAL_INT( (int)sizeof( buf ), (int)trace_encode_record( buf, &rec, &arg ) );
+  // type, argc, slot, pid, sim_ns, real_ns, then the argument; all little-endian
+  const unsigned char expect[] = { TRACE_DELTA_STATE, 1, 0xfe, 0xff, 0x04, 0x03, 0x02, 0x01, 0x88, 0x77, 0x66,
+                                   0x55, 0x44, 0x33, 0x22, 0x11, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                   0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+  TEST_ASSERT_EQUAL_MEMORY( expect, buf, sizeof( expect ) );
+}
+
+int main( void ) {
+  UNITY_BEGIN();
+  RUN_TEST( test_calendar_PopsInTimeOrder );
+  RUN_TEST( test_calendar_TiesPopFifo );
+  RUN_TEST( test_calendar_KeepsFutureEvents );
+  RUN_TEST( test_hist_SmallValuesAreExact );
+  RUN_TEST( test_hist_BucketWidthIsBounded );
+  RUN_TEST( test_hist_PercentileCappedAtMax );
+  RUN_TEST( test_wsdeque_PopIsLifoStealIsFifo );
+  RUN_TEST( test_wsdeque_StealPopRaceTakesEachItemOnce );
+  RUN_TEST( test_spsc_FullAndEmpty );
+  RUN_TEST( test_spsc_IndexWrapAround );
+  RUN_TEST( test_spsc_ThreadedOrder );
+  RUN_TEST( test_resmgr_DetectsCycle );
+  RUN_TEST( test_resmgr_WaiterBehindRunnerIsNotDeadlocked );
+  RUN_TEST( test_pager_FifoEvictsOldestLoad );
+  RUN_TEST( test_pager_ClockGivesSecondChance );
+  RUN_TEST( test_pager_LruEvictsLeastRecentlyUsed );
+  RUN_TEST( test_trace_FileRoundTrip );
+  RUN_TEST( test_trace_RecordLayoutIsFixed );
+  return UNITY_END();
+}